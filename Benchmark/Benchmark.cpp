@@ -0,0 +1,400 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Corpus.h"
+#include "Source/CommandLine.h"
+#include "Source/DictionaryReader.h"
+#include "Source/FileSystem.h"
+#include "Source/GroArchive.h"
+#include "Source/IndexCache.h"
+#include "Source/Stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Stream buffer that discards everything
+class CNullBuffer : public std::streambuf {
+  protected:
+    virtual int overflow(int ch) {
+      return ch;
+    };
+};
+
+// Hide regular output of the packer while it's being measured
+class CQuietOutput {
+  private:
+    CNullBuffer _buffer;
+    std::streambuf *_pOld;
+
+  public:
+    CQuietOutput() : _pOld(std::cout.rdbuf(&_buffer)) {};
+
+    ~CQuietOutput() {
+      std::cout.rdbuf(_pOld);
+    };
+};
+
+typedef void (*FBenchmark)(void);
+
+static CorpusSettings_t _settings;
+static Corpus_t _corpus;
+static size_t _ctIterations = 10;
+
+static CString _strGame; // Directory with generated files
+static CString _strOutput; // Output archive outside the game directory
+
+// Prepared inputs
+static Strings_t _aDependQueries; // Lowercase names of both standard and other files
+static Strings_t _aFileQueries; // Names of both listed and missing files
+static ScanResult_t _texResult; // Effect textures that have been found in some file
+
+// Results that cannot be optimized away
+static size_t _ctFound = 0;
+
+// Measure one benchmark over multiple iterations, preparing each of them separately
+static void Measure(const c8 *strName, size_t ctOps, FBenchmark pSetup, FBenchmark pRun) {
+  std::vector<double> aSeconds;
+
+  // First run only warms up file caches
+  for (size_t iRun = 0; iRun <= _ctIterations; ++iRun) {
+    if (pSetup != nullptr) pSetup();
+
+    CQuietOutput quiet;
+    CStopwatch sw;
+
+    pRun();
+
+    if (iRun != 0) aSeconds.push_back(sw.Seconds());
+  }
+
+  std::sort(aSeconds.begin(), aSeconds.end());
+
+  const double dMin = aSeconds.front();
+  const double dMedian = aSeconds[aSeconds.size() / 2];
+
+  std::cout << std::left << std::setw(32) << strName << std::right
+    << std::setw(12) << std::fixed << std::setprecision(3) << (dMin * 1000.0)
+    << std::setw(14) << (dMedian * 1000.0)
+    << std::setw(16) << std::setprecision(0) << (dMin > 0.0 ? ctOps / dMin : 0.0) << '\n';
+};
+
+// Remove cache files from the last run
+static void RemoveCacheFiles(void) {
+  remove((_strGame + "Temp/DreamyGRO_StdIndex.bin").c_str());
+  remove((_strGame + "Temp/DreamyGRO_ScanCache.bin").c_str());
+};
+
+// Load standard dependencies from every archive
+static void IgnoreStdGROs(void) {
+  for (size_t i = 0; i < _corpus.aStdGROs.size(); ++i) {
+    IgnoreGRO(_corpus.aStdGROs[i]);
+  }
+};
+
+static void SetupIgnoreCold(void) {
+  _aStdDepends.Clear();
+  _cacheStdDepends.Reset();
+  RemoveCacheFiles();
+};
+
+static void SetupIgnoreCached(void) {
+  _aStdDepends.Clear();
+};
+
+static void RunInDepends(void) {
+  for (size_t i = 0; i < _aDependQueries.size(); ++i) {
+    if (InDepends(_aDependQueries[i])) ++_ctFound;
+  }
+};
+
+static void RunInFiles(void) {
+  for (size_t i = 0; i < _aFileQueries.size(); ++i) {
+    if (InFiles(_aFileQueries[i])) ++_ctFound;
+  }
+};
+
+static void RunScanFast(void) {
+  Strings_t aRefs;
+  ExtractReferences(_strGame + _corpus.strLibrary, true, SCANENGINE_FAST, aRefs);
+  _ctFound += aRefs.size();
+};
+
+static void RunScanStream(void) {
+  Strings_t aRefs;
+  ExtractReferences(_strGame + _corpus.strLibrary, true, SCANENGINE_STREAM, aRefs);
+  _ctFound += aRefs.size();
+};
+
+static void SetupScanWorld(void) {
+  _cacheScans.Reset();
+};
+
+static void RunScanWorld(void) {
+  ScanResult_t result;
+  CollectDependencies(_corpus.strWorld, _strGame + _corpus.strWorld, result);
+  _ctFound += result.aRefs.size();
+};
+
+static void SetupFiles(void) {
+  _aFilesToPack.Clear();
+};
+
+static void RunTextures(void) {
+  MergeDependencies(_texResult);
+};
+
+static void SetupPackCold(void) {
+  _cacheStdDepends.Reset();
+  _cacheScans.Reset();
+  RemoveCacheFiles();
+};
+
+static void RunPack(void) {
+  _aStdDepends.Clear();
+  _aFilesToPack.Clear();
+  _aScanFiles.assign(1, _corpus.strWorld);
+  _strGRO = _strOutput;
+
+  IgnoreStdGROs();
+  ScanIncludedFiles();
+  ProcessDependencies();
+};
+
+static void SetupPackCached(void) {
+  // Load both caches from files like the next run would
+  _cacheStdDepends.Save();
+  _cacheStdDepends.Reset();
+  _cacheScans.Reset();
+};
+
+// Make sure that included files that cannot be opened are still reported as errors
+static void CheckMissingIncludes(void) {
+  static const c8 *astrMissing[] = { "Textures/Missing.tex", "Models/Missing.mdl", "Levels/Missing.wld" };
+
+  for (size_t i = 0; i < sizeof(astrMissing) / sizeof(astrMissing[0]); ++i) {
+    _aFilesToPack.Clear();
+    _aScanFiles.assign(1, astrMissing[i]);
+
+    bool bFailed = false;
+
+    try {
+      CQuietOutput quiet;
+      ScanIncludedFiles();
+
+    } catch (CMessageException &) {
+      bFailed = true;
+    }
+
+    if (!bFailed) {
+      CMessageException::Throw("Scanning missing '%s' didn't fail!", astrMissing[i]);
+    }
+  }
+
+  _aFilesToPack.Clear();
+  _aScanFiles.clear();
+  _bCountFiles = false;
+};
+
+// Make sure that files from source archives aren't scanned as if they were the archives themselves
+static void CheckSourceArchives(void) {
+  if (!_groSources.Add(_strGame + _corpus.strSourceGRO)) {
+    throw CMessageException("Cannot open the source archive!");
+  }
+
+  _aFilesToPack.Clear();
+  _aScanFiles.assign(1, _corpus.strSourceList);
+  _iFlags |= SCAN_REC;
+
+  {
+    CQuietOutput quiet;
+    ScanIncludedFiles();
+  }
+
+  if (!InFiles(_corpus.strSourceModel)) {
+    throw CMessageException("Model from the source archive hasn't been found!");
+  }
+
+  if (InFiles(_corpus.strSourceRef)) {
+    throw CMessageException("Source archive has been scanned instead of the model in it!");
+  }
+
+  _groSources.Clear();
+  _cacheScans.Reset();
+  RemoveCacheFiles();
+
+  _iFlags &= ~SCAN_REC;
+  _aFilesToPack.Clear();
+  _aScanFiles.clear();
+  _bCountFiles = false;
+};
+
+// Read a numeric option
+static size_t ReadNumber(s32 &iArg, s32 ctArgs, char *astrArgs[]) {
+  if (iArg + 1 >= ctArgs) {
+    throw CMessageException(CString("Expected a number after '") + astrArgs[iArg] + "'!");
+  }
+
+  return (size_t)strtoul(astrArgs[++iArg], nullptr, 10);
+};
+
+// Display available options
+static void Usage(void) {
+  std::cout << "Usage: DreamyGRO_Benchmark [options]\n"
+    "  -d <dir>     Directory for generated files (default: DreamyGRO_Benchmark/)\n"
+    "  -n <count>   Entries in standard GRO archives (default: 50000)\n"
+    "  -w <count>   Filenames in each world dictionary (default: 2000)\n"
+    "  -x <count>   FX textures (default: 500)\n"
+    "  -l <size>    Library size in KB (default: 4096)\n"
+    "  -s <seed>    Seed for generating files (default: 1)\n"
+    "  -i <count>   Measured iterations of each benchmark (default: 10)\n"
+    "  -j <count>   Threads for scanning and packing (default: 1, 0 for all cores)\n";
+};
+
+// Entry point
+int main(int ctArgs, char *astrArgs[]) {
+  std::cout << "Dreamy GRO Benchmark - (c) Dreamy Cecil, 2022-2024\n";
+
+  CString strDir = "DreamyGRO_Benchmark/";
+
+  try {
+    for (s32 iArg = 1; iArg < ctArgs; ++iArg) {
+      const CString strArg = astrArgs[iArg];
+
+      if (strArg == "-d" && iArg + 1 < ctArgs) {
+        strDir = astrArgs[++iArg];
+
+      } else if (strArg == "-n") {
+        _settings.ctGroEntries = ReadNumber(iArg, ctArgs, astrArgs);
+      } else if (strArg == "-w") {
+        _settings.ctWorldNames = ReadNumber(iArg, ctArgs, astrArgs);
+      } else if (strArg == "-x") {
+        _settings.ctTextures = ReadNumber(iArg, ctArgs, astrArgs);
+      } else if (strArg == "-l") {
+        _settings.iLibrarySize = ReadNumber(iArg, ctArgs, astrArgs) * 1024;
+      } else if (strArg == "-s") {
+        _settings.iSeed = (u32)ReadNumber(iArg, ctArgs, astrArgs);
+      } else if (strArg == "-i") {
+        _ctIterations = ReadNumber(iArg, ctArgs, astrArgs);
+      } else if (strArg == "-j") {
+        _ctThreads = ReadNumber(iArg, ctArgs, astrArgs);
+
+      } else {
+        Usage();
+        return 1;
+      }
+    }
+
+    if (_ctIterations == 0 || _settings.ctWorldNames == 0) {
+      throw CMessageException("Iterations and world filenames cannot be zero!");
+    }
+
+    // Make absolute path
+    strDir.Normalize();
+    if (strDir.IsRelative()) strDir = GetCurrentPath() + strDir;
+
+    if (!strDir.PathSeparatorAt(strDir.length() - 1)) {
+      strDir += '/';
+    }
+
+    _strGame = strDir + "Game/";
+    _strOutput = strDir + "Bench.gro";
+
+    // Generate files
+    std::cout << "\nGenerating files in '" << _strGame << "'...\n";
+
+    CStopwatch swGenerate;
+    GenerateCorpus(_strGame, _settings, _corpus);
+
+    std::cout << "Seed: " << _settings.iSeed
+      << ", standard entries: " << _settings.ctGroEntries << " in " << _corpus.aStdGROs.size() << " GROs"
+      << ", world filenames: " << (_settings.ctWorldNames * 2)
+      << ", FX textures: " << _settings.ctTextures
+      << ", library: " << (_settings.iLibrarySize / 1024) << " KB"
+      << ", threads: " << GetThreadCount() << '\n';
+
+    std::cout << "Generated in " << std::fixed << std::setprecision(3) << swGenerate.Seconds() << " s\n";
+
+    // Set up the packer the same way the command line does
+    _strRoot = _strGame;
+    _strMod = "";
+    _iFlags = 0;
+    _fileIndex.Build(_strRoot, _strMod, GetThreadCount());
+
+    CheckMissingIncludes();
+    CheckSourceArchives();
+
+    for (size_t i = 0; i < _corpus.aStdNames.size(); ++i) {
+      _aDependQueries.push_back(_corpus.aStdNames[i].AsLower());
+    }
+
+    for (size_t i = 0; i < _corpus.aFiles.size(); ++i) {
+      _aDependQueries.push_back(_corpus.aFiles[i].AsLower());
+
+      _aFileQueries.push_back(_corpus.aFiles[i]);
+      _aFileQueries.push_back(_corpus.aMissing[i]);
+    }
+
+    _texResult.strFile = _corpus.strWorld;
+    _texResult.aRefs = _corpus.aTextures;
+
+    std::cout << '\n' << std::left << std::setw(32) << "Benchmark" << std::right
+      << std::setw(12) << "Min (ms)" << std::setw(14) << "Median (ms)" << std::setw(16) << "Ops/s" << '\n';
+
+    Measure("IgnoreGRO (no cache)", _settings.ctGroEntries, &SetupIgnoreCold, &IgnoreStdGROs);
+    Measure("IgnoreGRO (cached)", _settings.ctGroEntries, &SetupIgnoreCached, &IgnoreStdGROs);
+
+    Measure("InDepends", _aDependQueries.size(), nullptr, &RunInDepends);
+
+    // List half of the queried files
+    _aFilesToPack.Clear();
+
+    for (size_t i = 0; i < _corpus.aFiles.size(); ++i) {
+      AddFile(_corpus.aFiles[i]);
+    }
+
+    Measure("InFiles", _aFileQueries.size(), nullptr, &RunInFiles);
+
+    Measure("ScanAnyFile (fast)", 1, nullptr, &RunScanFast);
+    Measure("ScanAnyFile (stream)", 1, nullptr, &RunScanStream);
+    Measure("ScanWorld (no cache)", 1, &SetupScanWorld, &RunScanWorld);
+    Measure("ScanWorld (cached)", 1, nullptr, &RunScanWorld);
+    Measure("AddExtrasWithTEX", _corpus.aTextures.size(), &SetupFiles, &RunTextures);
+
+    Measure("Packing (no caches)", 1, &SetupPackCold, &RunPack);
+    Measure("Packing (cached)", 1, &SetupPackCached, &RunPack);
+
+    RemoveCacheFiles();
+    remove(_strOutput.c_str());
+
+  } catch (CMessageException &ex) {
+    std::cout << "Error: " << ex.what() << '\n';
+    return 1;
+
+  } catch (std::runtime_error &err) {
+    std::cout << "Error: " << err.what() << '\n';
+    return 1;
+  }
+
+  std::cout << "\nTotal results: " << _ctFound << '\n';
+  return 0;
+};
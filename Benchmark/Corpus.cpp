@@ -0,0 +1,318 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Corpus.h"
+#include "Source/GroArchive.h"
+
+#include <algorithm>
+#include <random>
+#include <stdio.h>
+
+#if _DREAMY_UNIX
+  #include <sys/stat.h>
+#else
+  #include <direct.h>
+#endif
+
+// Most entries that are written into one standard archive
+static const size_t _ctEntriesPerGRO = 50000;
+
+// Deterministic source of random values
+class CCorpusRandom {
+  private:
+    std::mt19937 _gen;
+
+  public:
+    CCorpusRandom(u32 iSeed) : _gen(iSeed) {};
+
+    // Random value from 0 to iRange - 1
+    inline u32 Next(u32 iRange) {
+      return (u32)(_gen() % iRange);
+    };
+};
+
+// Create all directories on the way to a file
+static void MakeDirs(const CString &strFile) {
+  size_t iSlash = strFile.find('/', 1);
+
+  while (iSlash != CString::npos) {
+    const CString strDir = strFile.substr(0, iSlash);
+
+  #if _DREAMY_UNIX
+    mkdir(strDir.c_str(), 0755);
+  #else
+    _mkdir(strDir.c_str());
+  #endif
+
+    iSlash = strFile.find('/', iSlash + 1);
+  }
+};
+
+// Write data into a new file
+static void WriteFile(const CString &strFile, const std::vector<u8> &aData) {
+  MakeDirs(strFile);
+
+  FILE *pFile = fopen(strFile.c_str(), "wb");
+
+  if (pFile == nullptr) {
+    throw CMessageException("Cannot create '" + strFile + "'!");
+  }
+
+  if (!aData.empty()) fwrite(&aData[0], 1, aData.size(), pFile);
+  fclose(pFile);
+};
+
+// Append values in the same format as data streams
+static void AppendData(std::vector<u8> &aData, const void *pData, size_t iSize) {
+  const u8 *pBytes = (const u8 *)pData;
+  aData.insert(aData.end(), pBytes, pBytes + iSize);
+};
+
+static void AppendChunk(std::vector<u8> &aData, const c8 *strChunk) {
+  AppendData(aData, strChunk, 4);
+};
+
+static void AppendU32(std::vector<u8> &aData, u32 iValue) {
+  const u8 aBytes[4] = { (u8)iValue, (u8)(iValue >> 8), (u8)(iValue >> 16), (u8)(iValue >> 24) };
+  AppendData(aData, aBytes, 4);
+};
+
+static void AppendString(std::vector<u8> &aData, const CString &str) {
+  AppendU32(aData, (u32)str.length());
+  AppendData(aData, str.c_str(), str.length());
+};
+
+// Append bytes that look like other game data but never contain any chunks
+static void AppendJunk(std::vector<u8> &aData, CCorpusRandom &rnd, size_t iSize) {
+  for (size_t i = 0; i < iSize; ++i) {
+    aData.push_back((u8)('a' + rnd.Next(16)));
+  }
+};
+
+// Filename with a number in it
+static CString NumberedFile(const c8 *strPrefix, size_t iNumber, const c8 *strExt) {
+  return strPrefix + CString(std::to_string((u64)iNumber).c_str()) + strExt;
+};
+
+// Write standard archives with empty entries
+static void GenerateStdGROs(Corpus_t &corpus, const CorpusSettings_t &settings) {
+  static const c8 *astrDirs[3] = { "Textures/Std/S", "Models/Std/S", "Sounds/Std/S" };
+  static const c8 *astrExts[3] = { ".tex", ".mdl", ".wav" };
+
+  for (size_t iEntry = 0; iEntry < settings.ctGroEntries; ++iEntry) {
+    corpus.aStdNames.push_back(NumberedFile(astrDirs[iEntry % 3], iEntry, astrExts[iEntry % 3]));
+  }
+
+  const size_t ctGROs = (settings.ctGroEntries + _ctEntriesPerGRO - 1) / _ctEntriesPerGRO;
+
+  for (size_t iGRO = 0; iGRO < ctGROs; ++iGRO) {
+    const CString strGRO = NumberedFile("Std_", iGRO, ".gro");
+    MakeDirs(corpus.strRoot + strGRO);
+
+    CGroWriter gro;
+    gro.Create(corpus.strRoot + strGRO);
+
+    const size_t iLast = std::min(settings.ctGroEntries, (iGRO + 1) * _ctEntriesPerGRO);
+
+    for (size_t iEntry = iGRO * _ctEntriesPerGRO; iEntry < iLast; ++iEntry) {
+      GroEntry_t entry;
+      entry.strName = corpus.aStdNames[iEntry];
+
+      gro.AddEntry(entry, nullptr);
+    }
+
+    gro.Finish();
+    corpus.aStdGROs.push_back(strGRO);
+  }
+};
+
+// Write files that are referenced by the world and the library
+static void GenerateFiles(Corpus_t &corpus, const CorpusSettings_t &settings, CCorpusRandom &rnd) {
+  static const c8 *astrDirs[3] = { "Textures/Bench/T", "Models/Bench/M", "Sounds/Bench/W" };
+  static const c8 *astrExts[3] = { ".tex", ".mdl", ".wav" };
+
+  std::vector<u8> aData;
+
+  for (size_t iFile = 0; iFile < settings.ctWorldNames; ++iFile) {
+    const CString strFile = NumberedFile(astrDirs[iFile % 3], iFile, astrExts[iFile % 3]);
+
+    // Partially compressible contents
+    aData.clear();
+    AppendJunk(aData, rnd, 1024 + rnd.Next(15 * 1024));
+
+    WriteFile(corpus.strRoot + strFile, aData);
+    corpus.aFiles.push_back(strFile);
+
+    corpus.aMissing.push_back(NumberedFile("Textures/Missing/X", iFile, ".tex"));
+  }
+
+  for (size_t iTex = 0; iTex < settings.ctTextures; ++iTex) {
+    const CString strTexture = NumberedFile("Textures/FX/FX", iTex, ".tex");
+    const CString strBase = NumberedFile("Textures/FX/Base", iTex, ".tex");
+
+    // Regular base texture
+    aData.clear();
+    AppendJunk(aData, rnd, 4096);
+    WriteFile(corpus.strRoot + strBase, aData);
+
+    // Effect texture with the base texture path at the very end
+    aData.clear();
+    AppendJunk(aData, rnd, 36);
+    AppendChunk(aData, "FXDT");
+    AppendJunk(aData, rnd, 256 + rnd.Next(1024));
+    aData.push_back('\0');
+    AppendData(aData, strBase.c_str(), strBase.length());
+
+    WriteFile(corpus.strRoot + strTexture, aData);
+    corpus.aTextures.push_back(strTexture);
+  }
+};
+
+// Pick a referenced filename out of all kinds of files
+static const CString &PickReference(const Corpus_t &corpus, CCorpusRandom &rnd, size_t iName) {
+  const u32 iKind = rnd.Next(10);
+
+  // Standard dependencies
+  if (iKind < 4 && !corpus.aStdNames.empty()) {
+    return corpus.aStdNames[rnd.Next((u32)corpus.aStdNames.size())];
+
+  // Effect textures
+  } else if (iKind == 4 && !corpus.aTextures.empty()) {
+    return corpus.aTextures[rnd.Next((u32)corpus.aTextures.size())];
+
+  // Files that don't exist
+  } else if (iKind == 5) {
+    return corpus.aMissing[iName];
+  }
+
+  return corpus.aFiles[iName];
+};
+
+// Write a world with both dictionaries after some other data
+static void GenerateWorld(Corpus_t &corpus, const CorpusSettings_t &settings, CCorpusRandom &rnd) {
+  corpus.strWorld = "Levels/Bench.wld";
+
+  std::vector<u8> aData;
+
+  AppendChunk(aData, "BUIV");
+  AppendU32(aData, 10000);
+  AppendChunk(aData, "WRLD");
+
+  // World info
+  AppendChunk(aData, "WLIF");
+  AppendString(aData, "Benchmark");
+  AppendU32(aData, 0);
+  AppendString(aData, "Synthetic world for benchmarking");
+
+  AppendJunk(aData, rnd, settings.iWorldJunk);
+
+  for (size_t iDict = 0; iDict < 2; ++iDict) {
+    AppendChunk(aData, "DPOS");
+    AppendU32(aData, (u32)(aData.size() + 4));
+
+    AppendChunk(aData, "DICT");
+    AppendU32(aData, (u32)settings.ctWorldNames);
+
+    for (size_t iName = 0; iName < settings.ctWorldNames; ++iName) {
+      AppendChunk(aData, "DFNM");
+      AppendString(aData, PickReference(corpus, rnd, iName));
+    }
+
+    AppendChunk(aData, "DEND");
+  }
+
+  WriteFile(corpus.strRoot + corpus.strWorld, aData);
+
+  // Extra files next to the world
+  aData.clear();
+  AppendJunk(aData, rnd, 4096);
+  WriteFile(corpus.strRoot + "Levels/Bench.vis", aData);
+};
+
+// Write a library with filenames scattered across random data
+static void GenerateLibrary(Corpus_t &corpus, const CorpusSettings_t &settings, CCorpusRandom &rnd) {
+  corpus.strLibrary = "Bin/Bench.dll";
+
+  std::vector<u8> aData;
+  aData.reserve(settings.iLibrarySize + settings.ctLibraryNames * 64);
+
+  const size_t iStep = settings.iLibrarySize / (settings.ctLibraryNames + 1);
+
+  for (size_t iName = 0; iName < settings.ctLibraryNames; ++iName) {
+    for (size_t i = 0; i < iStep; ++i) {
+      aData.push_back((u8)rnd.Next(256));
+    }
+
+    const CString &strName = PickReference(corpus, rnd, iName % settings.ctWorldNames);
+
+    AppendChunk(aData, "EFNM");
+    AppendData(aData, strName.c_str(), strName.length() + 1);
+  }
+
+  while (aData.size() < settings.iLibrarySize) {
+    aData.push_back((u8)rnd.Next(256));
+  }
+
+  WriteFile(corpus.strRoot + corpus.strLibrary, aData);
+};
+
+// Write an archive with a model that's only referenced by a file on disk
+static void GenerateSourceGRO(Corpus_t &corpus) {
+  corpus.strSourceGRO = "Source.gro";
+  corpus.strSourceList = "Data/Source.txt";
+  corpus.strSourceModel = "Models/Source/M.mdl";
+  corpus.strSourceRef = "Textures/Source/T.tex";
+
+  std::vector<u8> aData;
+  const CString strModel = "TFNM " + corpus.strSourceRef + "\n";
+  AppendData(aData, strModel.c_str(), strModel.length());
+
+  CGroWriter gro;
+  gro.Create(corpus.strRoot + corpus.strSourceGRO);
+
+  GroEntry_t entry;
+  entry.strName = corpus.strSourceModel;
+  entry.iCRC = ComputeCRC(0, &aData[0], aData.size());
+  entry.iPackedSize = entry.iSize = (u32)aData.size();
+
+  gro.AddEntry(entry, &aData[0]);
+  gro.Finish();
+
+  aData.clear();
+  const CString strList = "TFNM " + corpus.strSourceModel + "\n";
+  AppendData(aData, strList.c_str(), strList.length());
+
+  WriteFile(corpus.strRoot + corpus.strSourceList, aData);
+};
+
+// Generate synthetic game files under some directory
+void GenerateCorpus(const CString &strRoot, const CorpusSettings_t &settings, Corpus_t &corpus) {
+  CCorpusRandom rnd(settings.iSeed);
+
+  corpus = Corpus_t();
+  corpus.strRoot = strRoot;
+
+  GenerateStdGROs(corpus, settings);
+  GenerateFiles(corpus, settings, rnd);
+  GenerateWorld(corpus, settings, rnd);
+  GenerateLibrary(corpus, settings, rnd);
+  GenerateSourceGRO(corpus);
+};
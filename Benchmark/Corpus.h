@@ -0,0 +1,63 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_CORPUS_H
+#define _DREAMYGRO_INCL_CORPUS_H
+
+#include "Source/Main.h"
+
+// Sizes of the synthetic game directory
+struct CorpusSettings_t {
+  u32 iSeed; // Same seed always produces the same files
+
+  size_t ctGroEntries; // Entries in standard GRO archives
+  size_t ctWorldNames; // Filenames in each world dictionary
+  size_t iWorldJunk; // Bytes of other world data before the dictionaries
+  size_t iLibrarySize; // Size of the library
+  size_t ctLibraryNames; // Filenames scattered across the library
+  size_t ctTextures; // FX textures with base textures
+
+  CorpusSettings_t() : iSeed(1), ctGroEntries(50000), ctWorldNames(2000), iWorldJunk(1 << 20),
+    iLibrarySize(4 << 20), ctLibraryNames(2000), ctTextures(500) {};
+};
+
+// Files that have been generated
+struct Corpus_t {
+  CString strRoot; // Game directory with a trailing slash
+  Strings_t aStdGROs; // Standard archives relative to the root
+  CString strWorld; // World file relative to the root
+  CString strLibrary; // Library relative to the root
+
+  Strings_t aStdNames; // Entries of standard archives
+  Strings_t aFiles; // Files on disk that aren't in standard archives
+  Strings_t aMissing; // Files that don't exist anywhere
+  Strings_t aTextures; // FX textures
+
+  CString strSourceGRO; // Archive with a model that isn't on disk
+  CString strSourceList; // Text file on disk that references the model
+  CString strSourceModel; // Model that only exists in the archive
+  CString strSourceRef; // File that's only referenced by the model
+};
+
+// Generate synthetic game files under some directory
+void GenerateCorpus(const CString &strRoot, const CorpusSettings_t &settings, Corpus_t &corpus);
+
+#endif
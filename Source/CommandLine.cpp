@@ -20,9 +20,16 @@
  */
 
 #include "CommandLine.h"
+#include "DictionaryReader.h"
+#include "IndexCache.h"
+#include "GroArchive.h"
+#include "FileSystem.h"
+#include "Layout.h"
+#include "Stats.h"
 
-#include <ZipLib/ZipFile.h>
-#include <ZipLib/ZipArchiveEntry.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 static void DisplayHelp(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
   // Get next argument immediately
@@ -116,6 +123,58 @@ static void ParseOutput(Strings_t::const_iterator &it, const Strings_t::const_it
   ++it;
 };
 
+// Add relative path to one file for scanning
+static void AddIncludedFile(const CString &strFile) {
+  _aScanFiles.push_back(strFile);
+
+  // The world itself should be packed too
+  const CString strExt = strFile.GetFileExt().AsLower();
+
+  if (strExt == ".wld") {
+    AddFile(strFile);
+  }
+};
+
+// Patterns of included files that are waiting for the file index
+static Strings_t _astrIncludePatterns;
+
+// Included files that have been matched by patterns
+static Strings_t _astrMatchedFiles;
+
+// Include all indexed files that match a pattern
+static void AddIncludedPattern(const CString &strPattern) {
+  Strings_t aFiles;
+
+  // Included files are relative to the mod directory
+  _fileIndex.Match(_strMod + strPattern, aFiles);
+
+  // Sort files because the index isn't in any particular order
+  std::sort(aFiles.begin(), aFiles.end(), [](const CString &str1, const CString &str2) {
+    return str1.AsLower() < str2.AsLower();
+  });
+
+  size_t ctIncluded = 0;
+
+  for (size_t iFile = 0; iFile < aFiles.size(); ++iFile) {
+    const CString strFile = aFiles[iFile].substr(_strMod.length());
+
+    // Skip files that would only be scanned by brute force for nothing (e.g. debug symbols)
+    if (!IsScannableFile(strFile)) continue;
+
+    AddIncludedFile(strFile);
+    _astrMatchedFiles.push_back(strFile);
+    ++ctIncluded;
+  }
+
+  std::cout << "Included files matching \"" << strPattern << "\": " << ctIncluded;
+
+  if (ctIncluded != aFiles.size()) {
+    std::cout << " (" << (aFiles.size() - ctIncluded) << " of other types skipped)";
+  }
+
+  std::cout << '\n';
+};
+
 static void ParseInclude(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
   // Get next argument immediately
   Strings_t::const_iterator itNext = it;
@@ -129,16 +188,18 @@ static void ParseInclude(Strings_t::const_iterator &it, const Strings_t::const_i
   CString strFile = *itNext;
   strFile.Replace('\\', '/'); // Fix slashes
 
-  _aScanFiles.push_back(strFile);
+  ++it;
 
-  // The world itself should be packed too
-  const CString strExt = strFile.GetFileExt().AsLower();
+  if (!IsFilePattern(strFile)) {
+    AddIncludedFile(strFile);
 
-  if (strExt == ".wld") {
-    AddFile(strFile);
-  }
+  // Match files from the index once it's ready
+  } else if (_fileIndex.IsBuilt()) {
+    AddIncludedPattern(strFile);
 
-  ++it;
+  } else {
+    _astrIncludePatterns.push_back(strFile);
+  }
 };
 
 static void ParseStoreFile(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
@@ -163,6 +224,49 @@ static void ParseStoreFile(Strings_t::const_iterator &it, const Strings_t::const
   _aNoCompression.push_back(strExt);
 };
 
+static void ParseCompression(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No level
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a compression level after '-c'!");
+  }
+
+  const CString strArg = (*itNext).AsLower();
+  ++it;
+
+  // Level of a specific file type
+  const size_t iEquals = strArg.find('=');
+  const CString strLevel = (iEquals == NULL_POS ? strArg : CString(strArg.substr(iEquals + 1)));
+
+  ECompressionLevel eLevel;
+
+  if (!ParseCompressionLevel(strLevel, eLevel)) {
+    CMessageException::Throw("Unknown compression level '%s'", strLevel.c_str());
+  }
+
+  if (iEquals == NULL_POS) {
+    _eCompression = eLevel;
+    return;
+  }
+
+  CompressionRule_t rule;
+  rule.strExt = strArg.substr(0, iEquals);
+  rule.eLevel = eLevel;
+
+  if (rule.strExt == "") {
+    CMessageException::Throw("Expected a file type before '=' in '%s'", strArg.c_str());
+  }
+
+  // Add a period to the extension
+  if (rule.strExt[0] != '.') {
+    rule.strExt = "." + rule.strExt;
+  }
+
+  _aCompressionRules.push_back(rule);
+};
+
 // Dependency files and GROs
 static Strings_t _astrDependencies;
 
@@ -180,6 +284,22 @@ static void ParseDependency(Strings_t::const_iterator &it, const Strings_t::cons
   ++it;
 };
 
+// Archives to copy entries from
+static Strings_t _astrSourceGROs;
+
+static void ParseArchive(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No file path
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a path to a GRO file after '-a'!");
+  }
+
+  _astrSourceGROs.push_back(*itNext);
+  ++it;
+};
+
 static void ParseFlag(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
   // Get next argument immediately
   Strings_t::const_iterator itNext = it;
@@ -205,9 +325,182 @@ static void ParseFlag(Strings_t::const_iterator &it, const Strings_t::const_iter
     _iFlags |= SCAN_GRO;
   } else if (strFlag == "mod") {
     _iFlags |= SCAN_MOD;
+  } else if (strFlag == "inc") {
+    _iFlags |= SCAN_INC;
+  } else if (strFlag == "rec") {
+    _iFlags |= SCAN_REC;
+  } else if (strFlag == "auto") {
+    _iFlags |= SCAN_AUTO;
+  }
+};
+
+static void ParseEngine(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No engine
+  if (itNext == itEnd) {
+    throw CMessageException("Expected an engine name after '-e'!");
+  }
+
+  const CString strEngine = (*itNext).AsLower();
+  ++it;
+
+  if (strEngine == "fast") {
+    _eScanEngine = SCANENGINE_FAST;
+  } else if (strEngine == "stream") {
+    _eScanEngine = SCANENGINE_STREAM;
+  } else if (strEngine == "compare") {
+    _eScanEngine = SCANENGINE_COMPARE;
+  } else {
+    CMessageException::Throw("Unknown scanning engine '%s'", strEngine.c_str());
+  }
+};
+
+static void ParseLayout(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No layout
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a layout name after '-l'!");
+  }
+
+  const CString strLayout = (*itNext).AsLower();
+  ++it;
+
+  if (strLayout == "found") {
+    _eLayout = LAYOUT_FOUND;
+  } else if (strLayout == "load") {
+    _eLayout = LAYOUT_LOAD;
+  } else if (strLayout == "dir") {
+    _eLayout = LAYOUT_DIR;
+  } else {
+    CMessageException::Throw("Unknown layout '%s'", strLayout.c_str());
   }
 };
 
+static void ParseAlignment(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No alignment
+  if (itNext == itEnd) {
+    throw CMessageException("Expected an amount of bytes after '-al'!");
+  }
+
+  const CString &strAlignment = *itNext;
+  ++it;
+
+  // Must be a power of two that fits into the extra field
+  const unsigned long iAlignment = strtoul(strAlignment.c_str(), nullptr, 10);
+
+  if (strAlignment == "" || strAlignment.find_first_not_of("0123456789") != NULL_POS
+   || iAlignment > 32768 || (iAlignment & (iAlignment - 1)) != 0) {
+    CMessageException::Throw("Invalid alignment '%s'", strAlignment.c_str());
+  }
+
+  _iAlignment = (u32)iAlignment;
+};
+
+static void ParseThreads(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No amount
+  if (itNext == itEnd) {
+    throw CMessageException("Expected an amount of threads after '-j'!");
+  }
+
+  const CString &strThreads = *itNext;
+  ++it;
+
+  // Must be a non-negative number
+  if (strThreads == "" || strThreads.find_first_not_of("0123456789") != NULL_POS) {
+    CMessageException::Throw("Invalid amount of threads '%s'", strThreads.c_str());
+  }
+
+  _ctThreads = (size_t)strtoul(strThreads.c_str(), nullptr, 10);
+};
+
+static void ParseBatch(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No manifest
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a path to a batch manifest after '-b'!");
+  }
+
+  _strBatch = *itNext;
+  ++it;
+
+  // Make absolute path
+  if (_strBatch.IsRelative()) _strBatch = GetCurrentPath() + _strBatch;
+  _strBatch.Normalize();
+};
+
+static void ParseSharedMinJobs(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No amount
+  if (itNext == itEnd) {
+    throw CMessageException("Expected an amount of jobs after '-shm'!");
+  }
+
+  const CString &strJobs = *itNext;
+  ++it;
+
+  // Must be a positive number
+  if (strJobs == "" || strJobs.find_first_not_of("0123456789") != NULL_POS || strtoul(strJobs.c_str(), nullptr, 10) == 0) {
+    CMessageException::Throw("Invalid amount of jobs '%s'", strJobs.c_str());
+  }
+
+  _ctSharedMinJobs = (size_t)strtoul(strJobs.c_str(), nullptr, 10);
+};
+
+static void ParseShared(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No file path
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a path to a GRO file after '-sh'!");
+  }
+
+  _strSharedGRO = *itNext;
+  ++it;
+};
+
+static void ParseStatsJSON(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Get next argument immediately
+  Strings_t::const_iterator itNext = it;
+
+  // No file path
+  if (itNext == itEnd) {
+    throw CMessageException("Expected a path to a JSON file after '-tj'!");
+  }
+
+  _strStatsJSON = *itNext;
+  ++it;
+};
+
+static void ParseStats(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Display timings at the end
+  _bStats = true;
+};
+
+static void ParseWatch(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Keep repacking after changes
+  _bWatch = true;
+};
+
+static void ParseVerify(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
+  // Check the existing GRO instead of packing it
+  _bVerify = true;
+};
+
 static void ParsePause(Strings_t::const_iterator &it, const Strings_t::const_iterator &itEnd) {
   // Pause at the end of execution
   _bPauseAtTheEnd = true;
@@ -235,28 +528,112 @@ const CmdArg_t _aCmdArgs[] {
     "  -i Levels/MyLevel.wld\n"
     "  -i Data/Messages/MyLevel.txt\n"
     "  -i Textures/MyEffectTexture.tex\n"
-    "  -i Bin/MyEntities.dll",
+    "  -i Bin/MyEntities.dll\n"
+    "  -i \"Levels/MyCampaign/*.wld\" - all matching files in one directory\n"
+    "  -i Bin/ - all files in a directory and its subdirectories\n"
+    "  Patterns only match file types that can be scanned (worlds, textures, models, texts, configs and libraries)",
     &ParseInclude },
 
+  // Must be checked before "shared" and "store" because arguments are matched by their beginning
+  { "shared-min", "shm", "Set how many batch jobs must use a file for it to be packed into the common GRO (2 by default)",
+    "  -shm 3",
+    &ParseSharedMinJobs },
+
+  // Must be checked before "store" because arguments are matched by their beginning
+  { "shared", "sh", "Scan all batch jobs first and pack files that are used by multiple jobs into a common GRO only once.\n"
+    "  GROs of each job only get files that are unique to them. If full path isn't specified, defaults to the root directory + mod folder",
+    "  -b Batch.txt -sh MapPackShared.gro",
+    &ParseShared },
+
   { "store", "s", "Specify file types to store in the archive without any compression",
     "  -s wld\n"
     "  -s .ogg",
     &ParseStoreFile },
 
+  { "compression", "c", "Set compression level of all files or of specific file types (default level by default)",
+    "  -c fast - compress quickly at the cost of a bigger archive\n"
+    "  -c default - balance between speed and size\n"
+    "  -c max - make the archive as small as possible\n"
+    "  -c wld=max\n"
+    "  -c .wav=fast",
+    &ParseCompression },
+
   { "depend", "d", "Mark specific resources or entire GRO archives as \"standard\" dependencies that will be skipped during scanning",
     "  -d MyResources.gro\n"
     "  -d Textures/MyTexture.tex",
     &ParseDependency },
 
+  // Must be checked before "archive" because arguments are matched by their beginning
+  { "align", "al", "Start data of stored entries at positions that are multiples of some power of two (0 to disable), so they can be mapped into memory",
+    "  -al 4096",
+    &ParseAlignment },
+
+  { "archive", "a", "Copy files that aren't on disk from an existing GRO archive as is without recompressing them",
+    "  -a SharedAssets.gro",
+    &ParseArchive },
+
   { "flag", "f", "Set certain behavior flags",
+    "  -f auto - store files without compression if a sample of their data barely compresses (e.g. OGG, MP3)\n"
     "  -f dep - display a list of dependencies of included files without packing anything into a GRO\n"
     "  -f gro - automatically detect GRO files from certain games instead of manually adding them\n"
+    "  -f inc - update an existing GRO by only recompressing files that have changed since the last time\n"
     "  -f ini - include INI files alongside their respective MDL files\n"
     "  -f mod - erase mod directory from paths to dependencies (e.g. packs \"Mods\\MyMod\\Texture1.tex\" as \"Texture1.tex\")\n"
     "  -f ogg - check for the existence of OGG files if MP3 files cannot be found\n"
+    "  -f rec - also scan found models, model configs and effect textures for their own dependencies\n"
     "  -f ssr - mark files as being from Serious Sam Revolution (detects automatically from WLD files)",
     &ParseFlag },
 
+  { "engine", "e", "Set engine for scanning files for dependencies (fast by default)",
+    "  -e fast - search for filenames in a file that's mapped into memory\n"
+    "  -e stream - go through the file one byte at a time\n"
+    "  -e compare - run both engines and make sure that they find the same files",
+    &ParseEngine },
+
+  { "layout", "l", "Set order of files in the archive (found by default)",
+    "  -l found - in the order that they have been found in\n"
+    "  -l load - worlds with their thumbnails and VIS files first and the rest in the order of world dictionaries\n"
+    "  -l dir - worlds with their thumbnails and VIS files first and the rest grouped by directories and file types",
+    &ParseLayout },
+
+  { "jobs", "j", "Set amount of threads for scanning and compressing files in parallel (0 to use all cores; 1 by default)",
+    "  -j 0\n"
+    "  -j 8",
+    &ParseThreads },
+
+  { "batch", "b", "Pack multiple GROs from a manifest file using the same standard dependencies. Each line of a text manifest\n"
+    "  is a job with a file to scan, an optional output GRO and optional arguments (-i, -o, -s, -c, -d or -f). JSON manifests are\n"
+    "  arrays of objects with \"include\" (string or array), \"output\" and \"args\" (array) fields",
+    "  -b Batch.txt\n"
+    "\n"
+    "  Batch.txt:\n"
+    "    Levels/MyLevel1.wld MyLevel1.gro\n"
+    "    Levels/MyLevel2.wld MyLevel2.gro -s ogg -f ini\n"
+    "\n"
+    "  Batch.json:\n"
+    "    [ { \"include\": \"Levels/MyLevel1.wld\", \"output\": \"MyLevel1.gro\" },\n"
+    "      { \"include\": \"Levels/MyLevel2.wld\", \"output\": \"MyLevel2.gro\", \"args\": [\"-s\", \"ogg\"] } ]",
+    &ParseBatch },
+
+  // Must be checked before "stats" because arguments are matched by their beginning
+  { "stats-json", "tj", "Write timings and throughput of each phase into a JSON file",
+    "  -tj Stats.json",
+    &ParseStatsJSON },
+
+  { "stats", "t", "Display timings of each phase, throughput, compression ratio of each file type and the slowest files",
+    "  -t",
+    &ParseStats },
+
+  { "watch", "w", "Keep running after packing the GRO and repack it whenever included files or their dependencies change.\n"
+    "  Only changed files are rescanned and unchanged entries are reused from the existing GRO",
+    "  -w",
+    &ParseWatch },
+
+  { "verify", "v", "Compare entries in an existing GRO with their files on disk instead of packing it. Only reads the central directory\n"
+    "  of the archive and reports missing, stale and extra entries. Exit code is 0 only when the archive is up to date",
+    "  -v",
+    &ParseVerify },
+
   { "pause", "p", "Pause program execution at the very end in order to see the final output",
     "  -p",
     &ParsePause },
@@ -285,9 +662,86 @@ void CmdHelp(s32 iCommand) {
     << "\n\nExample:\n" << arg.strExample << '\n';
 };
 
+// Set path to the output GRO relative to the game
+static void SetupOutputGRO(void) {
+  if (OnlyDep()) return;
+
+  // Make path to a GRO from the first file to be scanned
+  if (_strGRO == "") {
+    const CString strFile = _aScanFiles[0];
+    _strGRO = _strRoot + _strMod + "DreamyGRO_" + strFile.GetFileName() + ".gro";
+
+  } else {
+    // Relative to the mod directory
+    if (_strMod != "") {
+      _strGRO = _strMod + _strGRO;
+    }
+
+    // Relative to the root directory
+    if (_strGRO.IsRelative()) {
+      _strGRO = _strRoot + _strGRO;
+    }
+  }
+
+  _strGRO.Normalize();
+};
+
+// Add specified dependencies to a set of standard ones
+static void AddDependencies(CDependencySet &aDepends) {
+  // Go through dependencies
+  for (size_t iDepend = 0; iDepend < _astrDependencies.size(); ++iDepend) {
+    const CString &strDepend = _astrDependencies[iDepend];
+
+    // Copy path for various checks
+    const CString strCheck = strDepend.AsLower();
+
+    // Scan entire GRO archive
+    if (strCheck.GetFileExt() == ".gro") {
+      IgnoreGRO(strDepend, aDepends);
+      continue;
+    }
+
+    // Skip if it doesn't exist under either directory
+    const CString strUnderMod = _strRoot + _strMod + strDepend;
+    const CString strUnderRoot = _strRoot + strDepend;
+
+    if (!FindFile(strUnderMod) && !FindFile(strUnderRoot)) {
+      std::cout << '"' << strDepend << "\" does not exist!\n";
+      continue;
+    }
+
+    // Add to existing dependencies if it's not there
+    aDepends.Add(strCheck);
+  }
+};
+
+// Open archives for copying entries from them
+static void OpenSourceArchives(void) {
+  for (size_t iSource = 0; iSource < _astrSourceGROs.size(); ++iSource) {
+    const CString &strSource = _astrSourceGROs[iSource];
+    CString strFullPath;
+
+    // Relative to the mod or the root directory
+    if (!strSource.IsRelative()) {
+      strFullPath = strSource;
+
+    } else if (!FindFile(_strRoot + _strMod + strSource, &strFullPath) && !FindFile(_strRoot + strSource, &strFullPath)) {
+      std::cout << '"' << strSource << "\" does not exist!\n";
+      continue;
+    }
+
+    if (!_groSources.Add(strFullPath)) {
+      std::cout << "Cannot read source archive \"" << strSource << "\"!\n";
+    }
+  }
+};
+
 // Parse command line arguments
 bool ParseArguments(Strings_t &aArgs) {
   _astrDependencies.clear();
+  _astrSourceGROs.clear();
+  _astrIncludePatterns.clear();
+  _astrMatchedFiles.clear();
 
   Strings_t::const_iterator it = aArgs.begin();
   const size_t ctArgs = aArgs.size();
@@ -330,7 +784,7 @@ bool ParseArguments(Strings_t &aArgs) {
   }
 
   // No files to scan
-  if (_aScanFiles.size() == 0) {
+  if (_aScanFiles.size() == 0 && _astrIncludePatterns.size() == 0 && _strBatch == "") {
     throw CMessageException("No files have been specified for scanning!");
   }
 
@@ -339,25 +793,46 @@ bool ParseArguments(Strings_t &aArgs) {
     throw CMessageException("Game folder path has not been set!");
   }
 
-  if (!OnlyDep()) {
-    // Make path to a GRO from the first file to be scanned
-    if (_strGRO == "") {
-      const CString strFile = _aScanFiles[0];
-      _strGRO = _strRoot + _strMod + "DreamyGRO_" + strFile.GetFileName() + ".gro";
+  // Common GRO is made from batch jobs
+  if (_strSharedGRO != "" && _strBatch == "") {
+    throw CMessageException("Common GRO can only be used with batch manifests!");
+  }
 
-    } else {
-      // Relative to the mod directory
-      if (_strMod != "") {
-        _strGRO = _strMod + _strGRO;
-      }
+  // Only one GRO can be repacked
+  if (_bWatch && (_strBatch != "" || OnlyDep() || _bVerify)) {
+    throw CMessageException("Watch mode cannot be used with batch manifests, dependency checks or verification!");
+  }
 
-      // Relative to the root directory
-      if (_strGRO.IsRelative()) {
-        _strGRO = _strRoot + _strGRO;
-      }
-    }
+  // Nothing to verify
+  if (_bVerify && OnlyDep()) {
+    throw CMessageException("Verification cannot be used with dependency checks!");
+  }
 
-    _strGRO.Normalize();
+  // List all files in the game once for existence checks
+  {
+    CPhaseTimer timer("Index files");
+    _fileIndex.Build(_strRoot, _strMod, GetThreadCount());
+  }
+
+  std::cout << "Indexed files: " << _fileIndex.Count() << '\n';
+
+  // Expand directories and wildcards using the index
+  for (size_t iPattern = 0; iPattern < _astrIncludePatterns.size(); ++iPattern) {
+    AddIncludedPattern(_astrIncludePatterns[iPattern]);
+  }
+
+  if (_aScanFiles.size() == 0 && _strBatch == "") {
+    throw CMessageException("No files match included patterns!");
+  }
+
+  // Output of each job is set up separately
+  if (_strBatch == "") {
+    SetupOutputGRO();
+
+  // Relative to the mod or the root directory
+  } else if (_strSharedGRO != "") {
+    if (_strSharedGRO.IsRelative()) _strSharedGRO = _strRoot + _strMod + _strSharedGRO;
+    _strSharedGRO.Normalize();
   }
 
   // Add GRO files from games automatically
@@ -371,37 +846,323 @@ bool ParseArguments(Strings_t &aArgs) {
     }
   }
 
-  // Go through dependencies
-  for (size_t iDepend = 0; iDepend < _astrDependencies.size(); ++iDepend) {
-    const CString &strDepend = _astrDependencies[iDepend];
+  AddDependencies(_aStdDepends);
+  OpenSourceArchives();
+  return true;
+};
 
-    // Copy path for various checks
-    const CString strCheck = strDepend.AsLower();
+// Patterns of included files relative to the mod directory
+const Strings_t &GetIncludedPatterns(void) {
+  return _astrIncludePatterns;
+};
 
-    // Scan entire GRO archive
-    if (strCheck.GetFileExt() == ".gro") {
-      IgnoreGRO(strDepend);
+// Match included patterns against the file index again after it has been rebuilt
+void RefreshIncludedPatterns(void) {
+  if (_astrIncludePatterns.empty()) return;
+
+  // Forget files that have been matched before
+  for (size_t iFile = 0; iFile < _astrMatchedFiles.size(); ++iFile) {
+    Strings_t::iterator itFound = std::find(_aScanFiles.begin(), _aScanFiles.end(), _astrMatchedFiles[iFile]);
+    if (itFound != _aScanFiles.end()) _aScanFiles.erase(itFound);
+  }
+
+  _astrMatchedFiles.clear();
+
+  // Only worlds from the remaining included files are listed before scanning
+  _aFilesToPack.Clear();
+
+  for (size_t iFile = 0; iFile < _aScanFiles.size(); ++iFile) {
+    if (_aScanFiles[iFile].GetFileExt().AsLower() == ".wld") AddFile(_aScanFiles[iFile]);
+  }
+
+  for (size_t iPattern = 0; iPattern < _astrIncludePatterns.size(); ++iPattern) {
+    AddIncludedPattern(_astrIncludePatterns[iPattern]);
+  }
+
+  if (_aScanFiles.size() == 0) {
+    throw CMessageException("No files match included patterns!");
+  }
+};
+
+// Commands that can be used by individual jobs in a batch manifest
+static bool IsJobCommand(FProcessCmdArg pFunc) {
+  return pFunc == &ParseInclude || pFunc == &ParseOutput || pFunc == &ParseStoreFile
+      || pFunc == &ParseCompression || pFunc == &ParseDependency || pFunc == &ParseFlag;
+};
+
+// Parse arguments of one job from the batch manifest
+void ParseJobArguments(const Strings_t &aArgs) {
+  _astrDependencies.clear();
+  _astrMatchedFiles.clear();
+
+  size_t ctPositional = 0;
+  Strings_t::const_iterator it = aArgs.begin();
+
+  while (it != aArgs.end()) {
+    // Get the string and advance the argument
+    const CString &str = *(it++);
+
+    // Plain strings are a file to scan and an output GRO
+    if (str[0] != '-') {
+      Strings_t aPositional;
+      aPositional.push_back(str);
+
+      Strings_t::const_iterator itPositional = aPositional.begin();
+
+      switch (ctPositional++) {
+        case 0: ParseInclude(itPositional, aPositional.end()); break;
+        case 1: ParseOutput(itPositional, aPositional.end()); break;
+        default: CMessageException::Throw("Unexpected job argument '%s'", str.c_str());
+      }
       continue;
     }
 
-    // Skip if it doesn't exist under either directory
-    const CString strUnderMod = _strRoot + _strMod + strDepend;
-    const CString strUnderRoot = _strRoot + strDepend;
+    // Starts with one dash
+    const bool bShort = (str[1] != '-');
+    bool bProcessArgument = false;
 
-    if (!FileExists(strUnderMod) && !FileExists(strUnderRoot)) {
-      std::cout << '"' << strDepend << "\" does not exist!\n";
+    for (size_t iArg = 0; iArg < _ctCmdArgs; ++iArg) {
+      const CmdArg_t &arg = _aCmdArgs[iArg];
+
+      if (bShort) {
+        bProcessArgument = str.StartsWith(CString("-") + arg.strShort);
+      } else {
+        bProcessArgument = str.StartsWith(CString("--") + arg.strFull);
+      }
+
+      if (!bProcessArgument) continue;
+
+      // Global settings cannot be changed per job
+      if (!IsJobCommand(arg.pFunc)) {
+        CMessageException::Throw("'%s' cannot be used by individual jobs", str.c_str());
+      }
+
+      arg.pFunc(it, aArgs.end());
+      break;
+    }
+
+    // Couldn't process the argument
+    if (!bProcessArgument) {
+      CMessageException::Throw("Unknown job argument '%s'", str.c_str());
+    }
+  }
+
+  // No files to scan
+  if (_aScanFiles.size() == 0) {
+    throw CMessageException("No files have been specified for scanning!");
+  }
+
+  SetupOutputGRO();
+
+  // Keep dependencies of this job apart from the ones that all jobs share
+  AddDependencies(_aJobDepends);
+};
+
+// Split one line of a text manifest into arguments
+static void SplitManifestLine(const CString &strLine, Strings_t &aArgs) {
+  size_t iChar = 0;
+  const size_t ctChars = strLine.length();
+
+  while (iChar < ctChars) {
+    // Skip whitespaces
+    if (isspace((u8)strLine[iChar])) {
+      ++iChar;
       continue;
     }
 
-    size_t iHash;
+    CString strArg;
 
-    // Add to existing dependencies if it's not there
-    if (!InDepends(strCheck, &iHash)) {
-      _aStdDepends.push_back(iHash);
+    // Quoted argument
+    if (strLine[iChar] == '"') {
+      const size_t iEnd = strLine.find('"', iChar + 1);
+
+      if (iEnd == NULL_POS) {
+        CMessageException::Throw("Unterminated quote in the batch manifest line '%s'", strLine.c_str());
+      }
+
+      strArg = strLine.substr(iChar + 1, iEnd - iChar - 1);
+      iChar = iEnd + 1;
+
+    } else {
+      const size_t iStart = iChar;
+      while (iChar < ctChars && !isspace((u8)strLine[iChar])) ++iChar;
+
+      strArg = strLine.substr(iStart, iChar - iStart);
     }
+
+    aArgs.push_back(strArg);
   }
+};
 
-  return true;
+// Minimal reader of JSON manifests that only understands strings, arrays and objects
+class CManifestJSON {
+  private:
+    const CString &_str;
+    size_t _iPos;
+
+  public:
+    CManifestJSON(const CString &str) : _str(str), _iPos(0) {};
+
+    // Read array of job objects
+    void ReadJobs(std::vector<Strings_t> &aJobs) {
+      Expect('[');
+
+      if (Next(']')) return;
+
+      do {
+        Strings_t aArgs;
+        ReadJob(aArgs);
+        aJobs.push_back(aArgs);
+      } while (Next(','));
+
+      Expect(']');
+    };
+
+  private:
+    // Read one job object and turn it into job arguments
+    void ReadJob(Strings_t &aArgs) {
+      Expect('{');
+
+      if (Next('}')) return;
+
+      do {
+        const CString strKey = ReadString().AsLower();
+        Expect(':');
+
+        if (strKey == "include") {
+          Strings_t aValues;
+          ReadValues(aValues);
+
+          for (size_t i = 0; i < aValues.size(); ++i) {
+            aArgs.push_back("-i");
+            aArgs.push_back(aValues[i]);
+          }
+
+        } else if (strKey == "output") {
+          aArgs.push_back("-o");
+          aArgs.push_back(ReadString());
+
+        } else if (strKey == "args") {
+          ReadValues(aArgs);
+
+        } else {
+          CMessageException::Throw("Unknown job field '%s' in the batch manifest", strKey.c_str());
+        }
+      } while (Next(','));
+
+      Expect('}');
+    };
+
+    // Read one string or an array of strings
+    void ReadValues(Strings_t &aValues) {
+      SkipSpaces();
+
+      if (!Next('[')) {
+        aValues.push_back(ReadString());
+        return;
+      }
+
+      if (Next(']')) return;
+
+      do {
+        aValues.push_back(ReadString());
+      } while (Next(','));
+
+      Expect(']');
+    };
+
+    // Read quoted string
+    CString ReadString(void) {
+      SkipSpaces();
+      Expect('"');
+      CString strValue;
+
+      while (_iPos < _str.length() && _str[_iPos] != '"') {
+        c8 ch = _str[_iPos++];
+
+        // Escape sequences
+        if (ch == '\\' && _iPos < _str.length()) {
+          ch = _str[_iPos++];
+
+          switch (ch) {
+            case 'n': ch = '\n'; break;
+            case 't': ch = '\t'; break;
+            case '"': case '\\': case '/': break;
+            default: CMessageException::Throw("Unsupported escape sequence '\\%c' in the batch manifest", ch);
+          }
+        }
+
+        strValue += ch;
+      }
+
+      Expect('"');
+      return strValue;
+    };
+
+    void SkipSpaces(void) {
+      while (_iPos < _str.length() && isspace((u8)_str[_iPos])) ++_iPos;
+    };
+
+    // Skip a specific character if it's next
+    bool Next(c8 ch) {
+      SkipSpaces();
+
+      if (_iPos < _str.length() && _str[_iPos] == ch) {
+        ++_iPos;
+        return true;
+      }
+
+      return false;
+    };
+
+    void Expect(c8 ch) {
+      // Strings are read as is
+      if (ch != '"') SkipSpaces();
+
+      if (_iPos >= _str.length() || _str[_iPos] != ch) {
+        CMessageException::Throw("Expected '%c' at position %u in the batch manifest", ch, (u32)_iPos);
+      }
+
+      ++_iPos;
+    };
+};
+
+// Read jobs from a batch manifest
+void ReadBatchManifest(const CString &strFile, std::vector<Strings_t> &aJobs) {
+  std::ifstream strm(strFile.c_str(), std::ios::binary);
+
+  if (!strm) {
+    CMessageException::Throw("Cannot open batch manifest '%s'", strFile.c_str());
+  }
+
+  std::stringstream ss;
+  ss << strm.rdbuf();
+  const CString strManifest = ss.str();
+
+  // JSON manifest
+  const size_t iFirst = strManifest.find_first_not_of(" \t\r\n");
+
+  if (iFirst != NULL_POS && strManifest[iFirst] == '[') {
+    CManifestJSON json(strManifest);
+    json.ReadJobs(aJobs);
+    return;
+  }
+
+  // Text manifest with one job per line
+  std::istringstream ssLines(strManifest);
+  std::string strLine;
+
+  while (std::getline(ssLines, strLine)) {
+    CString strJob = strLine;
+
+    // Skip comments
+    const size_t iStart = strJob.find_first_not_of(" \t\r");
+    if (iStart == NULL_POS || strJob[iStart] == '#' || strJob.compare(iStart, 2, "//") == 0) continue;
+
+    Strings_t aArgs;
+    SplitManifestLine(strJob, aArgs);
+    aJobs.push_back(aArgs);
+  }
 };
 
 // Detect root game directory from a full path to the file
@@ -553,6 +1314,8 @@ EGameType DetectGame(const CString &strDir) {
 
 // Automatically ignore GRO files from a specific game
 void IgnoreGame(EGameType eGame, bool bSetFlagsFromGame) {
+  CPhaseTimer timer("IgnoreGame");
+
   switch (eGame) {
     // Ignore TSE resources
     case GAME_TSE: {
@@ -597,38 +1360,63 @@ void IgnoreGame(EGameType eGame, bool bSetFlagsFromGame) {
 };
 
 // Ignore dependencies from a GRO file
-void IgnoreGRO(const CString &strGRO) {
-  CString strFullPath = _strRoot + _strMod + strGRO;
+void IgnoreGRO(const CString &strGRO, CDependencySet &aDepends) {
+  CPhaseTimer timer("IgnoreGRO " + strGRO);
+  CString strFullPath;
 
-  if (!FileExists(strFullPath)) {
-    strFullPath = _strRoot + strGRO;
+  // Skip if it doesn't exist under either directory
+  if (!FindFile(_strRoot + _strMod + strGRO, &strFullPath) && !FindFile(_strRoot + strGRO, &strFullPath)) {
+    std::cout << '"' << strGRO << "\" does not exist!\n";
+    return;
   }
 
-  // Skip if it doesn't exist
-  if (!FileExists(strFullPath)) {
-    std::cout << '"' << strGRO << "\" does not exist!\n";
+  // Use names from the cache if the archive hasn't changed
+  FileInfo_t info;
+  GetFileInfo(strFullPath, info);
+
+  _cacheStdDepends.Load(_strRoot + "Temp/DreamyGRO_StdIndex.bin");
+
+  if (_cacheStdDepends.AddNames(strFullPath, info, aDepends)) {
+    return;
+  }
+
+  // Only go through names in the central directory
+  CGroDirectory dir;
+
+  if (!dir.Open(strFullPath)) {
+    std::cout << '"' << strGRO << "\" is not a valid GRO archive!\n";
     return;
   }
 
-  ZipArchive::Ptr pGRO = ZipFile::Open(strFullPath);
+  // Make space for all entries at once instead of growing the set for each one
+  const u64 ctEntries = dir.Count();
+  aDepends.Reserve(aDepends.Size() + (size_t)std::min(ctEntries, (u64)0x10000000));
+
+  std::vector<u8> aNames;
+  u32 ctNames = 0;
 
-  for (int i = 0; i < (int)pGRO->GetEntriesCount(); ++i) {
-    ZipArchiveEntry::Ptr file = pGRO->GetEntry(i);
+  const c8 *strName;
+  size_t ctChars;
 
+  while (dir.NextName(strName, ctChars)) {
     // Ignore directory entries
-    if (file->IsDirectory()) {
+    if (ctChars == 0 || strName[ctChars - 1] == '/' || strName[ctChars - 1] == '\\') {
       continue;
     }
 
-    // Make hash out of the filename in lowercase
-    CString strCheck = file->GetFullName();
-    strCheck.ToLower();
+    // Add filename in lowercase to existing dependencies if it's not there
+    aDepends.AddFolded(strName, ctChars);
 
-    size_t iHash;
+    CIndexCache::AppendName(aNames, strName, ctChars);
+    ++ctNames;
+  }
 
-    // Add to existing dependencies if it's not there
-    if (!InDepends(strCheck, &iHash)) {
-      _aStdDepends.push_back(iHash);
-    }
+  // Don't remember names from a broken archive
+  if (dir.IsBroken()) {
+    std::cout << '"' << strGRO << "\" has a broken central directory!\n";
+    return;
   }
+
+  // Remember names for the next time
+  _cacheStdDepends.SetNames(strFullPath, info, ctNames, aNames);
 };
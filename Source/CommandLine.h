@@ -54,6 +54,18 @@ enum EGameType {
 // Parse command line arguments
 bool ParseArguments(Strings_t &aArgs);
 
+// Patterns of included files relative to the mod directory
+const Strings_t &GetIncludedPatterns(void);
+
+// Match included patterns against the file index again after it has been rebuilt
+void RefreshIncludedPatterns(void);
+
+// Parse arguments of one job from the batch manifest
+void ParseJobArguments(const Strings_t &aArgs);
+
+// Read jobs from a batch manifest
+void ReadBatchManifest(const CString &strFile, std::vector<Strings_t> &aJobs);
+
 // Build parameters from the full path and return file path relative to the root directory
 CString FromFullFilePath(const CString &strFile, const CString &strDefaultFolderInRoot);
 
@@ -64,6 +76,6 @@ EGameType DetectGame(const CString &strDir);
 void IgnoreGame(EGameType eGame, bool bSetFlagsFromGame);
 
 // Ignore dependencies from a GRO file
-void IgnoreGRO(const CString &strGRO);
+void IgnoreGRO(const CString &strGRO, CDependencySet &aDepends = _aStdDepends);
 
 #endif
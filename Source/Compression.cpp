@@ -0,0 +1,96 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Compression.h"
+
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+#include <stdexcept>
+#include <string.h>
+
+ECompressionLevel _eCompression = COMPRESSION_DEFAULT;
+CCompressionRules _aCompressionRules;
+
+// Get compression level of some file
+ECompressionLevel GetCompressionLevel(const CString &strFile) {
+  const CString strExt = strFile.GetFileExt().AsLower();
+
+  // Rules that are added later take priority
+  for (size_t i = _aCompressionRules.size(); i > 0; --i) {
+    const CompressionRule_t &rule = _aCompressionRules[i - 1];
+    if (rule.strExt == strExt) return rule.eLevel;
+  }
+
+  return _eCompression;
+};
+
+// Convert level name into a compression level and return false if it's unknown
+bool ParseCompressionLevel(const CString &strLevel, ECompressionLevel &eLevel) {
+  if (strLevel == "fast") {
+    eLevel = COMPRESSION_FAST;
+  } else if (strLevel == "default") {
+    eLevel = COMPRESSION_DEFAULT;
+  } else if (strLevel == "max") {
+    eLevel = COMPRESSION_MAX;
+  } else {
+    return false;
+  }
+
+  return true;
+};
+
+// Compress data into a raw deflate stream (safe to call from multiple threads)
+void DeflateData(const u8 *pData, size_t iSize, std::vector<u8> &aCompressed, ECompressionLevel eLevel) {
+  static const int _aLevels[3] = { 1, Z_DEFAULT_COMPRESSION, 9 };
+
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+
+  // Negative window bits for raw deflate data without zlib headers
+  if (deflateInit2(&zs, _aLevels[eLevel], Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Cannot initialize deflate compression");
+  }
+
+  aCompressed.resize(deflateBound(&zs, (uLong)iSize) + 1);
+
+  zs.next_in = (Bytef *)pData;
+  zs.avail_in = (uInt)iSize;
+  zs.next_out = (Bytef *)&aCompressed[0];
+  zs.avail_out = (uInt)aCompressed.size();
+
+  const int iResult = deflate(&zs, Z_FINISH);
+  aCompressed.resize(zs.total_out);
+  deflateEnd(&zs);
+
+  if (iResult != Z_STREAM_END) {
+    throw std::runtime_error("Cannot compress data");
+  }
+};
+
+// Get general purpose flags of a deflated entry that describe its compression level
+u16 GetDeflateFlags(ECompressionLevel eLevel) {
+  // Bits 1 and 2: 00 - normal, 01 - maximum, 10 - fast
+  switch (eLevel) {
+    case COMPRESSION_FAST: return (1 << 2);
+    case COMPRESSION_MAX: return (1 << 1);
+    default: return 0;
+  }
+};
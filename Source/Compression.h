@@ -0,0 +1,61 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_COMPRESSION_H
+#define _DREAMYGRO_INCL_COMPRESSION_H
+
+#include <DreamyUtilities/Types/Arrays.hpp>
+
+using namespace dreamy;
+
+#include <vector>
+
+// Compression levels that trade ratio for speed
+enum ECompressionLevel {
+  COMPRESSION_FAST,
+  COMPRESSION_DEFAULT,
+  COMPRESSION_MAX,
+};
+
+// Compression level of specific file types
+struct CompressionRule_t {
+  CString strExt; // Lowercase extension with a period
+  ECompressionLevel eLevel;
+};
+
+typedef std::vector<CompressionRule_t> CCompressionRules;
+
+extern ECompressionLevel _eCompression; // Compression level of all files
+extern CCompressionRules _aCompressionRules; // Compression levels of specific file types
+
+// Get compression level of some file
+ECompressionLevel GetCompressionLevel(const CString &strFile);
+
+// Convert level name into a compression level and return false if it's unknown
+bool ParseCompressionLevel(const CString &strLevel, ECompressionLevel &eLevel);
+
+// Compress data into a raw deflate stream that Serious Engine can read (safe to call from multiple threads)
+void DeflateData(const u8 *pData, size_t iSize, std::vector<u8> &aCompressed, ECompressionLevel eLevel);
+
+// Get general purpose flags of a deflated entry that describe its compression level
+u16 GetDeflateFlags(ECompressionLevel eLevel);
+
+#endif
@@ -21,60 +21,47 @@
 
 #include "Main.h"
 #include "DictionaryReader.h"
-
-#if !_DREAMY_UNIX
-  #define WIN32_LEAN_AND_MEAN
-  #include <windows.h>
-
-  // Try to get offset of a section that's right after ".text" inside an executable file
-  static size_t GetSecondSectionOffset(const c8 *hModule) {
-    PIMAGE_DOS_HEADER pDOSHeader = (PIMAGE_DOS_HEADER)hModule;
-    PIMAGE_NT_HEADERS pNTHeader = (PIMAGE_NT_HEADERS)((size_t)pDOSHeader + pDOSHeader->e_lfanew);
-    PIMAGE_FILE_HEADER pFileHeader = &pNTHeader->FileHeader;
-    PIMAGE_SECTION_HEADER aSections = IMAGE_FIRST_SECTION(pNTHeader);
-
-    // Not enough sections
-    if (pFileHeader->NumberOfSections < 2) return NULL_POS;
-
-    PIMAGE_SECTION_HEADER pAfterText = aSections + 1;
-    return pAfterText->VirtualAddress;
-  };
-#endif
-
-// Fix filename if it's improper
-static void FixFilename(CString &strFilename) {
+#include "MappedFile.h"
+#include "Executable.h"
+#include "IndexCache.h"
+#include "FileSystem.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+// Fix filename in place if it's improper and return true if it's a filename from SSR
+static bool FixFilename(CString &strFilename) {
   // Forward slashes are only in SSR
-  if (strFilename.find('/') != NULL_POS) {
-    _iFlags |= SCAN_SSR;
-  }
+  bool bRev = (strFilename.find('/') != NULL_POS);
 
   // Make consistent slashes
   strFilename.Replace('\\', '/');
 
-  CString strFixed = "";
-  CString::const_iterator it;
-
-  for (it = strFilename.begin(); it != strFilename.end(); ++it) {
-    // Get next char
-    CString::const_iterator itNext = it + 1;
+  const size_t ctChars = strFilename.length();
+  size_t iWrite = 0;
 
+  for (size_t iRead = 0; iRead < ctChars; ++iRead) {
     // Double slashes are only in SSR
-    if (*it == '/' && *itNext == '/') {
-      _iFlags |= SCAN_SSR;
+    if (strFilename[iRead] == '/' && iRead + 1 < ctChars && strFilename[iRead + 1] == '/') {
+      bRev = true;
       continue;
     }
 
-    // Add character
-    strFixed += *it;
+    // Keep character
+    strFilename[iWrite++] = strFilename[iRead];
   }
 
+  strFilename.resize(iWrite);
+
   // Prefix slashes are only in SSR
-  if (strFixed[0] == '/') {
-    strFixed = strFixed.erase(0, 1);
-    _iFlags |= SCAN_SSR;
+  if (iWrite != 0 && strFilename[0] == '/') {
+    strFilename.erase(0, 1);
+    bRev = true;
   }
 
-  strFilename = strFixed;
+  return bRev;
 };
 
 // Add extra files with MDL
@@ -85,136 +72,229 @@ static void AddExtrasWithMDL(const CString &strFilename) {
   }
 };
 
-// Add extra files with TEX
-static void AddExtrasWithTEX(const CString &strRelativeTextureFile) {
-  CString strFilename = _strRoot + _strMod + strRelativeTextureFile;
+// Amount of bytes at the end of an FX texture that may contain the base texture path
+static const size_t _iTextureTailSize = 512;
+
+// Fixed amount of bytes in an FX texture that are unrelated to the base texture path
+static const size_t _iTextureFixedSize = 56;
+
+// Base texture that has been read from an FX texture
+struct TextureBase_t {
+  CString strTexture; // Full path to the FX texture
+  FileInfo_t info; // FX texture that the base texture has been read from
+  CString strBase; // Empty if it's not an FX texture
+  bool bOpened; // Whether the FX texture could be opened
+};
 
-  if (_strMod != "" && !FileExists(_strRoot + _strMod + strRelativeTextureFile)) {
-    strFilename = _strRoot + strRelativeTextureFile;
+// Base textures of FX textures that have already been read during this run
+static std::vector<TextureBase_t> _aTextureBases;
+static CHashIndex _indexTextureBases;
+
+// Textures can be read from multiple threads during scanning
+static std::mutex _mutexTextureBases;
+
+// Find last occurrence of a byte in memory
+static const u8 *FindLastByte(const u8 *pData, size_t iSize, u8 ch) {
+  for (const u8 *p = pData + iSize; p != pData;) {
+    if (*(--p) == ch) return p;
   }
 
-  // Pack base textures with FX textures
-  CFileDevice dTex(strFilename.c_str());
-  if (!dTex.Open(IReadWriteDevice::OM_READONLY)) return;
+  return nullptr;
+};
 
-  // Skip texture version and data with 6 values (including two chunks)
-  CDataStream strmTex(&dTex);
-  strmTex.Seek(36);
+// Read base texture path from the end of an FX texture (empty if it's not an FX texture)
+// Returns false if the file cannot be opened
+static bool ReadTextureBase(const CString &strTexture, CString &strBase) {
+  strBase = "";
 
-  // Make sure that FX texture is written
-  if (strmTex.Peek(4) != "FXDT") return;
+  FILE *pFile = fopen(strTexture.c_str(), "rb");
+  if (pFile == nullptr) return false;
 
-  // Skip to the end of the texture
-  strmTex.Seek(strmTex.Device()->Size() - 1);
+  // Skip texture version and data with 6 values (including two chunks) and make sure that FX texture is written
+  c8 aChunk[4];
 
-  s32 ctChars = 0;
+  if (fseek(pFile, 36, SEEK_SET) == 0 && fread(aChunk, 1, 4, pFile) == 4 && memcmp(aChunk, "FXDT", 4) == 0
+   && fseek(pFile, 0, SEEK_END) == 0)
+  {
+    const long iSize = ftell(pFile);
+
+    // Read the entire tail with the base texture path at once
+    if (iSize > (long)_iTextureFixedSize + 1) {
+      // Tail cannot overlap the fixed data
+      size_t iFirst = _iTextureFixedSize + 1;
+
+      if ((size_t)iSize > iFirst + _iTextureTailSize) {
+        iFirst = (size_t)iSize - _iTextureTailSize;
+      }
+
+      const size_t ctRead = (size_t)iSize - iFirst;
+
+      std::vector<u8> aTail(ctRead);
+
+      if (fseek(pFile, (long)iFirst, SEEK_SET) == 0 && fread(&aTail[0], 1, ctRead, pFile) == ctRead) {
+        // Path goes from the last null character until the end of the file
+        const u8 *pNull = FindLastByte(&aTail[0], ctRead, '\0');
+
+        if (pNull != nullptr) {
+          const size_t iPath = (pNull - &aTail[0]) + 1;
+          strBase = CString((const c8 *)&aTail[0] + iPath, ctRead - iPath);
+
+        // Path takes up the entire tail right after the fixed data
+        } else if (iFirst == _iTextureFixedSize + 1) {
+          strBase = CString((const c8 *)&aTail[0], ctRead);
+        }
+      }
+    }
+  }
+
+  fclose(pFile);
+  return true;
+};
+
+// Get base texture path of an FX texture, reading each texture only once unless it changes
+// Returns false if the file cannot be opened
+static bool GetTextureBase(const CString &strTexture, CString &strBase) {
+  FileInfo_t info;
+
+  if (!GetFileInfo(strTexture, info)) {
+    info.iSize = 0;
+    info.iTime = 0;
+  }
+
+  const u64 iHash = HashFilename(strTexture);
+  const std::vector<TextureBase_t> &aBases = _aTextureBases;
 
-  // Go backwards until the null character
-  // 56 is the fixed amount of bytes unrelated to the base texture path
-  while (strmTex.Pos() > 56)
   {
-    c8 ch;
-    strmTex.Peek(&ch, 1);
+    std::lock_guard<std::mutex> lock(_mutexTextureBases);
 
-    // Encountered a null character
-    if (ch == '\0') {
-      // Skip it
-      strmTex.Skip(1);
-      break;
+    const size_t iFound = _indexTextureBases.Find(iHash, [&](size_t iBase) {
+      return aBases[iBase].strTexture == strTexture;
+    });
+
+    // Reuse it if it hasn't been changed
+    if (iFound != NULL_POS) {
+      const TextureBase_t &base = aBases[iFound];
+
+      if (base.info.iSize == info.iSize && base.info.iTime == info.iTime) {
+        strBase = base.strBase;
+        return base.bOpened;
+      }
     }
+  }
+
+  // Read the file without blocking other threads
+  TextureBase_t base;
+  base.strTexture = strTexture;
+  base.info = info;
+  base.bOpened = ReadTextureBase(strTexture, base.strBase);
+
+  strBase = base.strBase;
+
+  std::lock_guard<std::mutex> lock(_mutexTextureBases);
 
-    // Move backward
-    strmTex.Seek(strmTex.Pos() - 1);
-    ++ctChars;
+  // Another thread may have added it in the meantime
+  const size_t iFound = _indexTextureBases.Find(iHash, [&](size_t iBase) {
+    return aBases[iBase].strTexture == strTexture;
+  });
+
+  if (iFound != NULL_POS) {
+    _aTextureBases[iFound] = base;
+  } else {
+    _aTextureBases.push_back(base);
+    _indexTextureBases.Insert(iHash, _aTextureBases.size() - 1);
   }
 
-  // No characters
-  if (ctChars == 0) return;
+  return base.bOpened;
+};
+
+// Add extra files with TEX
+static void AddExtrasWithTEX(const CString &strRelativeTextureFile) {
+  CString strFilename;
 
-  // Extract a string from the current position to the end of file
-  CByteArray baBaseTex = strmTex.Read(ctChars);
+  // Look under the mod directory first
+  if ((_strMod == "" || !FindFile(_strRoot + _strMod + strRelativeTextureFile, &strFilename))
+   && !FindFile(_strRoot + strRelativeTextureFile, &strFilename)) {
+    return;
+  }
+
+  // Pack base textures with FX textures
+  CString strBaseTex;
+  GetTextureBase(strFilename, strBaseTex);
+
+  // No characters
+  if (strBaseTex == "") return;
 
   // Read base texture file
-  CString strBaseTex = baBaseTex.ConstData();
-  FixFilename(strBaseTex);
+  if (FixFilename(strBaseTex)) _iFlags |= SCAN_SSR;
 
   // Check if the file already exists in the list of dependencies
-  CString strCheckTex = strBaseTex.AsLower();
+  CPathKey key;
+  key.Set(strBaseTex);
 
   // Proceed only if it's not there
-  if (InDepends(strCheckTex)) return;
-
-  bool bAdd = true;
+  if (InDepends(key)) return;
 
   if (IsRev()) {
     // Try with different directories
-    ReplaceRevDirs(strCheckTex);
-    bAdd = !InDepends(strCheckTex);
+    if (key.ReplaceRevDirs() && InDepends(key)) return;
 
     // Try replacing spaces
-    if (bAdd) {
-      strCheckTex.Replace(' ', '_');
-      bAdd = !InDepends(strCheckTex);
-    }
+    if (key.ReplaceSpaces() && InDepends(key)) return;
   }
 
   // Add base texture file
-  if (bAdd) AddFile(strBaseTex);
+  AddFile(strBaseTex);
 };
 
 // Add a specific file only if it exists and it's not in any lists of dependencies
-static void TryToAddFile(CString strFilename) {
+static void TryToAddFile(const CString &strFilename, CPathKey &key) {
   // Check if the file already exists in the list of dependencies
-  CString strCheckFile = strFilename.AsLower();
+  key.Set(strFilename);
+  size_t iStart = 0;
 
   // Remove mod directory
   if (EraseMod() && _strMod != "") {
     const CString strModCheck = _strMod.AsLower();
 
-    if (strCheckFile.StartsWith(strModCheck)) {
-      const size_t ctModCheck = strModCheck.length();
-
-      strFilename.erase(0, ctModCheck);
-      strCheckFile.erase(0, ctModCheck);
+    if (key.StartsWith(strModCheck)) {
+      iStart = strModCheck.length();
+      key.EraseStart(iStart);
     }
   }
 
+  // Hash of the filename for the list of files
+  const u64 iFileHash = key.Hash();
+
   // Skip if already in there
-  if (InDepends(strCheckFile)) return;
+  if (InDepends(key)) return;
 
   // Try with OGG if no MP3
-  if (PackOGG() && strCheckFile.GetFileExt() == ".mp3") {
-    strCheckFile = strCheckFile.RemoveExt() + ".ogg";
-
+  if (PackOGG() && key.ReplaceMP3WithOGG()) {
     // OGG is present instead of MP3
-    if (InDepends(strCheckFile)) return;
+    if (InDepends(key)) return;
   }
 
   if (IsRev()) {
     // Try with different directories
-    ReplaceRevDirs(strCheckFile);
-    if (InDepends(strCheckFile)) return;
+    if (key.ReplaceRevDirs() && InDepends(key)) return;
 
     // Try replacing spaces
-    strCheckFile.Replace(' ', '_');
-    if (InDepends(strCheckFile)) return;
+    if (key.ReplaceSpaces() && InDepends(key)) return;
   }
 
   // Add filename to the list if it's not there yet
-  if (!AddFile(strFilename)) return;
+  if (!AddFile(strFilename.c_str() + iStart, strFilename.length() - iStart, iFileHash)) return;
 
-  const CString strExt = strCheckFile.GetFileExt();
+  if (key.HasExt(".mdl")) {
+    AddExtrasWithMDL(strFilename.substr(iStart));
 
-  if (strExt == ".mdl") {
-    AddExtrasWithMDL(strFilename);
-
-  } else if (strExt == ".tex") {
-    AddExtrasWithTEX(strCheckFile);
+  } else if (key.HasExt(".tex")) {
+    AddExtrasWithTEX(key.Key());
   }
 };
 
-// Scan the dictionary of a world and extract filenames that aren't in existing dependencies
-static void ScanWorldDictionary(CDataStream &strm) {
+// Collect filenames from the dictionary of a world
+static void ReadWorldDictionary(CDataStream &strm, Strings_t &aRefs) {
   // Dictionary beginning
   strm.Expect(CByteArray("DICT", 4));
 
@@ -232,26 +312,36 @@ static void ScanWorldDictionary(CDataStream &strm) {
     // Skip empty filenames
     if (strFilename == "") continue;
 
-    FixFilename(strFilename);
-    TryToAddFile(strFilename);
+    aRefs.push_back(strFilename);
   }
 
   // Dictionary end
   strm.Expect(CByteArray("DEND", 4));
 };
 
-// Scan the world dictionary for dependencies
-void ScanWorld(const CString &strWorld) {
-  CFileDevice d((_strRoot + _strMod + strWorld).c_str());
+// Find position of a four-character chunk within a memory range
+static size_t FindChunk(const u8 *pData, size_t iPos, size_t iEnd, const c8 *strChunk) {
+  while (iPos + 4 <= iEnd) {
+    const u8 *pFirst = (const u8 *)memchr(pData + iPos, strChunk[0], iEnd - iPos - 3);
 
-  if (!d.Open(IReadWriteDevice::OM_READONLY)) {
-    throw CMessageException("Cannot open the file!");
+    // No more chunks
+    if (pFirst == nullptr) break;
+
+    if (memcmp(pFirst, strChunk, 4) == 0) return (pFirst - pData);
+
+    iPos = (pFirst - pData) + 1;
   }
 
+  return NULL_POS;
+};
+
+// Skip world info, find both dictionaries and read filenames from them
+static void LocateDictionaries(CDataStream &strm, const CString &strPath, WorldDictionaries_t &dicts, Strings_t &aRefs) {
   // Verify world file first
-  CDataStream strm(&d);
   VerifyWorldFile(strm);
 
+  dicts.iFlags = 0;
+
   // Parse world info before parsing the dictionary
   {
     CString strDummy;
@@ -269,14 +359,14 @@ void ScanWorld(const CString &strWorld) {
       strm.Skip(4);
       strm >> strDummy;
 
-      _iFlags |= SCAN_SSR;
+      dicts.iFlags |= SCAN_SSR;
     }
 
     // Skip another SSR chunk and its data (4 + 12)
     if (strm.Peek(4) == "Plv0") {
       strm.Skip(16);
 
-      _iFlags |= SCAN_SSR;
+      dicts.iFlags |= SCAN_SSR;
     }
 
     // Skip world name and spawn flags
@@ -287,100 +377,131 @@ void ScanWorld(const CString &strWorld) {
     if (strm.Peek(4) == "SpGM") {
       strm.Skip(4);
 
-      _iFlags |= SCAN_SSR;
+      dicts.iFlags |= SCAN_SSR;
     }
 
     // Skip world description
     strm >> strDummy;
   }
 
-  size_t ctLastFiles = _ctFiles;
+  // Dictionary position is usually written right after world info
+  if (strm.Peek(4) == "DPOS") {
+    dicts.iDictPos = (u32)strm.Pos();
 
-  {
-    const CString strNoExt = strWorld.RemoveExt();
+  // Otherwise search for it in the rest of the file
+  } else {
+    CMappedFile file;
 
-    // Add thumbnail texture
-    CString strExtra = strNoExt + "Tbn.tex";
-
-    // Try regular thumbnail
-    if (!FileExists(_strRoot + _strMod + strExtra)) {
-      strExtra = strNoExt + ".tbn";
+    if (!file.Open(strPath)) {
+      throw CMessageException("Cannot open the file!");
     }
 
-    if (FileExists(_strRoot + _strMod + strExtra)) {
-      AddFile(strExtra);
-    }
+    const size_t iFound = FindChunk(file.Data(), strm.Pos(), file.Size(), "DPOS");
+    file.Close();
 
-    // Add VIS file
-    strExtra = strNoExt + ".vis";
-
-    if (FileExists(_strRoot + _strMod + strExtra)) {
-      AddFile(strExtra);
+    if (iFound == NULL_POS) {
+      throw CMessageException("Cannot find the dictionary in the world file!");
     }
-  }
 
-  while (!strm.AtEnd()) {
-    // Found dictionary position
-    if (strm.Peek(4) == "DPOS") {
-      strm.Skip(4);
-      break;
-    }
-
-    // Move forward
-    strm.Skip(1);
+    dicts.iDictPos = (u32)iFound;
   }
 
   // Go to the dictionary
+  strm.Seek(dicts.iDictPos + 4);
+
   s32 iPos;
   strm >> iPos;
-  strm.Seek(iPos);
+  dicts.iBrushes = (u32)iPos;
 
   // Brush textures dictionary
-  ScanWorldDictionary(strm);
+  strm.Seek(iPos);
+  ReadWorldDictionary(strm, aRefs);
 
   // Expect the next dictionary position
   strm.Expect(CByteArray("DPOS", 4));
 
   // Go to the next dictionary
   strm >> iPos;
-  strm.Seek(iPos);
+  dicts.iEntities = (u32)iPos;
 
   // Entity resources dictionary
-  ScanWorldDictionary(strm);
+  strm.Seek(iPos);
+  ReadWorldDictionary(strm, aRefs);
+};
 
-  d.Close();
+// Collect extra files that are packed with the world
+static void AddWorldExtras(const CString &strWorld, ScanResult_t &result) {
+  const CString strNoExt = strWorld.RemoveExt();
 
-  // No dependencies have been added
-  if (_ctFiles == ctLastFiles) {
-    std::cout << "No dependencies\n";
+  // Add thumbnail texture
+  CString strExtra = strNoExt + "Tbn.tex";
+
+  // Try regular thumbnail
+  if (!FindFile(_strRoot + _strMod + strExtra)) {
+    strExtra = strNoExt + ".tbn";
+  }
+
+  if (FindFile(_strRoot + _strMod + strExtra)) {
+    result.aExtras.push_back(strExtra);
+  }
+
+  // Add VIS file
+  strExtra = strNoExt + ".vis";
+
+  if (FindFile(_strRoot + _strMod + strExtra)) {
+    result.aExtras.push_back(strExtra);
   }
 };
 
-// Scan any file for dependencies
-void ScanAnyFile(const CString &strFile, bool bLibrary) {
-  CFileDevice d((_strRoot + _strMod + strFile).c_str());
+// Collect dependencies from the world dictionary
+static void ReadWorld(const CString &strPath, ScanResult_t &result) {
+  CFileDevice d(strPath.c_str());
 
   if (!d.Open(IReadWriteDevice::OM_READONLY)) {
     throw CMessageException("Cannot open the file!");
   }
 
+  // Read filenames from both dictionaries
   CDataStream strm(&d);
-  size_t ctLastFiles = _ctFiles;
+  LocateDictionaries(strm, strPath, result.world, result.aRefs);
+
+  result.iFlags |= result.world.iFlags;
+
+  d.Close();
+};
+
+// Determine which parts of a file need to be scanned for filenames
+static void GetRangesToScan(const u8 *pData, size_t iSize, bool bLibrary, CFileRanges &aRanges) {
+  // Only scan sections with data in libraries
+  if (bLibrary && GetLibraryData(pData, iSize, aRanges) && !aRanges.empty()) return;
+
+  // Scan the entire file
+  aRanges.clear();
+  aRanges.push_back(FileRange_t(0, iSize));
+};
+
+// Extract raw filenames through a data stream one byte at a time
+static void ExtractWithStream(const CString &strPath, bool bLibrary, Strings_t &aRefs) {
+  CFileDevice d(strPath.c_str());
+
+  if (!d.Open(IReadWriteDevice::OM_READONLY)) {
+    throw CMessageException("Cannot open the file!");
+  }
+
+  CDataStream strm(&d);
+  CFileRanges aRanges;
 
-#if !_DREAMY_UNIX
   // Scan a library file to skip through bytes that don't have any strings
   if (bLibrary) {
     CByteArray aDLL = strm.Read(d.Size());
     d.Reset();
     strm.ResetStatus();
 
-    const size_t iPosAfterText = GetSecondSectionOffset(aDLL.ConstData());
+    GetRangesToScan((const u8 *)aDLL.ConstData(), d.Size(), true, aRanges);
 
-    if (iPosAfterText != NULL_POS) {
-      strm.Seek(iPosAfterText);
-    }
+  } else {
+    aRanges.push_back(FileRange_t(0, d.Size()));
   }
-#endif
 
   // Possible chunks
   const u32 iDFNM = *reinterpret_cast<const u32 *>("DFNM");
@@ -389,70 +510,455 @@ void ScanAnyFile(const CString &strFile, bool bLibrary) {
 
   c8 aReadChunk[4];
 
-  while (!strm.AtEnd()) {
-    // Try reading a chunk
-    if (strm.Peek(aReadChunk, 4) != 4) break;
+  for (size_t iRange = 0; iRange < aRanges.size(); ++iRange) {
+    const size_t iEnd = aRanges[iRange].iEnd;
+    strm.Seek(aRanges[iRange].iStart);
 
-    const u32 iChunk = *reinterpret_cast<const u32 *>(aReadChunk);
-    CString strFilename = "";
+    while (strm.Pos() < iEnd) {
+      // Try reading a chunk
+      if (strm.Pos() + 4 > iEnd || strm.Peek(aReadChunk, 4) != 4) break;
 
-    // Filename inside a data file
-    if (iChunk == iDFNM) {
-      strm.Skip(4);
+      const u32 iChunk = *reinterpret_cast<const u32 *>(aReadChunk);
+      CString strFilename = "";
 
-      u32 iSize = 0;
-      strm.Peek(&iSize, 4);
+      // Filename inside a data file
+      if (iChunk == iDFNM) {
+        strm.Skip(4);
 
-      // Make sure that's it's not too long
-      if (iSize < 254) {
-        strm >> strFilename;
-      }
+        u32 iSize = 0;
+        strm.Peek(&iSize, 4);
 
-    // Filename inside an executable file
-    } else if (iChunk == iEFNM) {
-      strm.Skip(4);
+        // Make sure that's it's not too long and that it fits
+        if (iSize < 254 && strm.Pos() + 4 + iSize <= iEnd) {
+          strm >> strFilename;
+        }
+
+      // Filename inside an executable file
+      } else if (iChunk == iEFNM) {
+        strm.Skip(4);
+
+        while (strm.Pos() < iEnd) {
+          c8 ch;
+          size_t iRead = strm.Peek(&ch, 1);
+
+          // Until either end
+          if (iRead != 1 || ch == '\0') break;
 
-      while (!strm.AtEnd()) {
-        c8 ch;
-        size_t iRead = strm.Peek(&ch, 1);
+          // Add the character
+          strFilename += ch;
+          strm.Skip(1);
+        }
 
-        // Until either end
-        if (iRead != 1 || ch == '\0') break;
+      // Filename inside a text file
+      } else if (iChunk == iTFNM) {
+        strm.Skip(5); // Skip extra space
 
-        // Add the character
-        strFilename += ch;
+        while (strm.Pos() < iEnd) {
+          c8 ch;
+          size_t iRead = strm.Peek(&ch, 1);
+
+          // Until either end
+          if (iRead != 1 || ch == '\n' || ch == '\r'  || ch == '\0' || strFilename.length() >= 254) break;
+
+          // Add the character
+          strFilename += ch;
+          strm.Skip(1);
+        }
+      }
+
+      // Add read filename
+      if (strFilename != "") {
+        aRefs.push_back(strFilename);
+
+      // Otherwise move forward
+      } else {
         strm.Skip(1);
       }
+    }
+  }
+
+  d.Close();
+};
+
+// Extract raw filenames from a range of bytes in memory
+static void ExtractFromRange(const u8 *pData, size_t iPos, size_t iEnd, Strings_t &aRefs) {
+  // All chunks end with the same three characters, so look for the 'F' in them
+  // and then check the first character of a potential chunk before it
+  while (iPos + 4 <= iEnd) {
+    const u8 *pF = (const u8 *)memchr(pData + iPos + 1, 'F', iEnd - iPos - 3);
+
+    // No more chunks
+    if (pF == nullptr) break;
+
+    const size_t iChunk = (pF - pData) - 1;
+    const c8 chType = pData[iChunk];
+
+    // Not a chunk
+    if (pF[1] != 'N' || pF[2] != 'M' || (chType != 'D' && chType != 'E' && chType != 'T')) {
+      iPos = iChunk + 1;
+      continue;
+    }
+
+    size_t iFilename = iChunk + 4;
+    size_t iFilenameEnd = iFilename;
+
+    // Filename inside a data file
+    if (chType == 'D') {
+      u32 iLength = 254;
+
+      if (iFilename + 4 <= iEnd) {
+        memcpy(&iLength, pData + iFilename, 4);
+      }
+
+      // Make sure that's it's not too long and that it fits
+      if (iLength < 254 && iFilename + 4 + iLength <= iEnd) {
+        iFilename += 4;
+        iFilenameEnd = iFilename + iLength;
+      }
+
+    // Filename inside an executable file
+    } else if (chType == 'E') {
+      const u8 *pNull = (const u8 *)memchr(pData + iFilename, '\0', iEnd - iFilename);
+      iFilenameEnd = (pNull != nullptr) ? (pNull - pData) : iEnd;
 
     // Filename inside a text file
-    } else if (iChunk == iTFNM) {
-      strm.Skip(5); // Skip extra space
+    } else {
+      ++iFilename; // Skip extra space
+      iFilenameEnd = iFilename;
 
-      while (!strm.AtEnd()) {
-        c8 ch;
-        size_t iRead = strm.Peek(&ch, 1);
+      // Up to 254 characters until either end
+      const size_t iLimit = std::min(iEnd, iFilename + 254);
 
-        // Until either end
-        if (iRead != 1 || ch == '\n' || ch == '\r'  || ch == '\0' || strFilename.length() >= 254) break;
+      while (iFilenameEnd < iLimit) {
+        const u8 ch = pData[iFilenameEnd];
+        if (ch == '\n' || ch == '\r' || ch == '\0') break;
 
-        // Add the character
-        strFilename += ch;
-        strm.Skip(1);
+        ++iFilenameEnd;
       }
     }
 
     // Add read filename
-    if (strFilename != "") {
-      FixFilename(strFilename);
-      TryToAddFile(strFilename);
+    if (iFilenameEnd > iFilename) {
+      aRefs.push_back(CString((const c8 *)pData + iFilename, iFilenameEnd - iFilename));
+      iPos = iFilenameEnd;
 
     // Otherwise move forward
     } else {
-      strm.Skip(1);
+      iPos = iFilenameEnd + 1;
     }
   }
+};
 
-  d.Close();
+// Extract raw filenames from a file mapped into memory
+static void ExtractWithMapping(const CString &strPath, bool bLibrary, Strings_t &aRefs) {
+  CMappedFile file;
+
+  if (!file.Open(strPath)) {
+    throw CMessageException("Cannot open the file!");
+  }
+
+  // Reuse the same image for parsing library headers
+  CFileRanges aRanges;
+  GetRangesToScan(file.Data(), file.Size(), bLibrary, aRanges);
+
+  for (size_t iRange = 0; iRange < aRanges.size(); ++iRange) {
+    ExtractFromRange(file.Data(), aRanges[iRange].iStart, aRanges[iRange].iEnd, aRefs);
+  }
+
+  file.Close();
+};
+
+// Scanning engine that's currently in use
+EScanEngine _eScanEngine = SCANENGINE_FAST;
+
+// Extract raw filenames from any file using a specific engine
+void ExtractReferences(const CString &strPath, bool bLibrary, EScanEngine eEngine, Strings_t &aRefs) {
+  switch (eEngine) {
+    case SCANENGINE_STREAM:
+      ExtractWithStream(strPath, bLibrary, aRefs);
+      break;
+
+    // Run both engines and make sure that they produce identical results
+    case SCANENGINE_COMPARE: {
+      Strings_t aStreamRefs;
+      ExtractWithStream(strPath, bLibrary, aStreamRefs);
+      ExtractWithMapping(strPath, bLibrary, aRefs);
+
+      if (aStreamRefs != aRefs) {
+        CMessageException::Throw("Scanning engines returned different results for '%s' (%u from stream, %u from mapping)",
+          strPath.c_str(), (u32)aStreamRefs.size(), (u32)aRefs.size());
+      }
+    } break;
+
+    default:
+      ExtractWithMapping(strPath, bLibrary, aRefs);
+  }
+};
+
+// Parser of a specific file format that only reads parts of the file where references live
+// Returns false if the file needs to be scanned by brute force after all
+typedef bool (*FScanFormat)(const CString &strPath, ScanResult_t &result);
+
+struct FormatScanner_t {
+  const c8 *strExts; // Lowercase extensions of files in this format separated by spaces
+  size_t iMagicPos; // Position of the magic bytes in the file
+  const c8 *strMagic; // Bytes that identify files in this format regardless of their extension (empty if there are none)
+  FScanFormat pScan;
+};
+
+// Amount of bytes from the beginning of a file that are enough for checking magic bytes
+static const size_t _iHeaderSize = 64;
+
+// Read filenames from both world dictionaries
+static bool ScanWorldFormat(const CString &strPath, ScanResult_t &result) {
+  ReadWorld(strPath, result);
+  return true;
+};
+
+// Only effect textures can reference other files and only their base texture
+static bool ScanTextureFormat(const CString &strPath, ScanResult_t &result) {
+  CString strBase;
+
+  if (!GetTextureBase(strPath, strBase)) {
+    throw CMessageException("Cannot open the file!");
+  }
+
+  if (strBase == "") {
+    result.bSkipped = true;
+  } else {
+    result.aRefs.push_back(strBase);
+  }
+
+  return true;
+};
+
+// Read filenames after text tags in each line of a text file the same way as ExtractFromRange() does
+// Filenames end with the line, with any of the extra terminating characters or after 254 characters
+// Returns false if it's not a text file
+static bool ExtractFromLines(const CString &strPath, const c8 *strTerminators, bool bTrim, Strings_t &aRefs) {
+  FILE *pFile = fopen(strPath.c_str(), "rb");
+
+  if (pFile == nullptr) {
+    throw CMessageException("Cannot open the file!");
+  }
+
+  std::vector<c8> aText;
+  c8 aBuffer[4096];
+
+  for (size_t ctRead; (ctRead = fread(aBuffer, 1, sizeof(aBuffer), pFile)) != 0;) {
+    aText.insert(aText.end(), aBuffer, aBuffer + ctRead);
+  }
+
+  fclose(pFile);
+
+  const size_t ctText = aText.size();
+  if (ctText == 0) return true;
+
+  const c8 *pText = &aText[0];
+
+  // Binary data can only be scanned by brute force
+  if (memchr(pText, '\0', ctText) != nullptr) return false;
+
+  const c8 *pTextEnd = pText + ctText;
+
+  for (const c8 *pLine = pText; pLine < pTextEnd;) {
+    const c8 *pLineEnd = (const c8 *)memchr(pLine, '\n', pTextEnd - pLine);
+    if (pLineEnd == nullptr) pLineEnd = pTextEnd;
+
+    // Find every tag with a separator after it in the line
+    for (const c8 *p = pLine; p + 5 <= pLineEnd;) {
+      if (memcmp(p, "TFNM", 4) != 0) {
+        ++p;
+        continue;
+      }
+
+      const c8 *pFilename = p + 5;
+      const c8 *pFilenameEnd = pFilename;
+      const c8 *pLimit = std::min(pLineEnd, pFilename + 254);
+
+      while (pFilenameEnd < pLimit && *pFilenameEnd != '\r' && strchr(strTerminators, *pFilenameEnd) == nullptr) {
+        ++pFilenameEnd;
+      }
+
+      // Continue right after the filename or after the separator if there's no filename
+      p = (pFilenameEnd > pFilename) ? pFilenameEnd : pFilenameEnd + 1;
+
+      // Skip trailing spaces
+      while (bTrim && pFilenameEnd > pFilename && (pFilenameEnd[-1] == ' ' || pFilenameEnd[-1] == '\t')) {
+        --pFilenameEnd;
+      }
+
+      if (pFilenameEnd > pFilename) {
+        aRefs.push_back(CString(pFilename, pFilenameEnd - pFilename));
+      }
+    }
+
+    pLine = pLineEnd + 1;
+  }
+
+  return true;
+};
+
+// Filenames in message and config files take up the rest of the line
+static bool ScanTextFormat(const CString &strPath, ScanResult_t &result) {
+  if (!ExtractFromLines(strPath, "", false, result.aRefs)) return false;
+
+  // Make sure that scanning engines find the same filenames by brute force
+  if (_eScanEngine == SCANENGINE_COMPARE) {
+    Strings_t aRefs;
+    ExtractReferences(strPath, false, SCANENGINE_COMPARE, aRefs);
+
+    if (aRefs != result.aRefs) {
+      CMessageException::Throw("Scanning engines returned different results for '%s' (%u from lines, %u by brute force)",
+        strPath.c_str(), (u32)result.aRefs.size(), (u32)aRefs.size());
+    }
+  }
+
+  return true;
+};
+
+// Filenames in SKA model configs end with a semicolon and may have spaces before it
+static bool ScanModelConfigFormat(const CString &strPath, ScanResult_t &result) {
+  return ExtractFromLines(strPath, ";", true, result.aRefs);
+};
+
+// Scan only sections with data in libraries
+static bool ScanLibraryFormat(const CString &strPath, ScanResult_t &result) {
+  ExtractReferences(strPath, true, _eScanEngine, result.aRefs);
+  return true;
+};
+
+// Known file formats
+static const FormatScanner_t _aFormatScanners[] = {
+  { ".wld",      0, "BUIV", &ScanWorldFormat },
+  { ".tex",     36, "FXDT", &ScanTextureFormat },
+  { ".txt .ini", 0, "",     &ScanTextFormat },
+  { ".smc",      0, "",     &ScanModelConfigFormat },
+  { ".dll .exe", 0, "MZ",   &ScanLibraryFormat },
+  { ".so",       0, "\x7F" "ELF", &ScanLibraryFormat },
+};
+
+static const size_t _ctFormatScanners = (sizeof(_aFormatScanners) / sizeof(FormatScanner_t));
+
+// Check if the extension is in a list of extensions separated by spaces
+static bool ExtensionInList(const CString &strExt, const c8 *strList) {
+  const size_t ctExt = strExt.length();
+  if (ctExt == 0) return false;
+
+  for (const c8 *strFound = strstr(strList, strExt.c_str()); strFound != nullptr; strFound = strstr(strFound + 1, strExt.c_str())) {
+    const c8 chNext = strFound[ctExt];
+    const bool bStart = (strFound == strList || strFound[-1] == ' ');
+
+    if (bStart && (chNext == ' ' || chNext == '\0')) return true;
+  }
+
+  return false;
+};
+
+// Find scanner by the extension of a file or by its magic bytes
+static const FormatScanner_t *FindFormatScanner(const CString &strPath, const CString &strExt) {
+  for (size_t i = 0; i < _ctFormatScanners; ++i) {
+    if (ExtensionInList(strExt, _aFormatScanners[i].strExts)) return &_aFormatScanners[i];
+  }
+
+  // Read beginning of the file once for checking all magic bytes
+  FILE *pFile = fopen(strPath.c_str(), "rb");
+  if (pFile == nullptr) return nullptr;
+
+  u8 aHeader[_iHeaderSize];
+  const size_t ctHeader = fread(aHeader, 1, _iHeaderSize, pFile);
+  fclose(pFile);
+
+  for (size_t i = 0; i < _ctFormatScanners; ++i) {
+    const FormatScanner_t &scanner = _aFormatScanners[i];
+    const size_t ctMagic = strlen(scanner.strMagic);
+
+    // Text formats are only recognized by their extensions
+    if (ctMagic == 0) continue;
+
+    if (scanner.iMagicPos + ctMagic <= ctHeader && memcmp(aHeader + scanner.iMagicPos, scanner.strMagic, ctMagic) == 0) {
+      return &scanner;
+    }
+  }
+
+  return nullptr;
+};
+
+// Collect raw dependencies of an included file without modifying any global state
+void CollectDependencies(const CString &strFile, const CString &strPath, ScanResult_t &result) {
+  result.strFile = strFile;
+
+  const CString strCheckExt = strFile.GetFileExt().AsLower();
+
+  // Extra files may appear without changing the world itself
+  if (strCheckExt == ".wld") {
+    AddWorldExtras(strFile, result);
+  }
+
+  // Engines are compared on actual files instead of cached results
+  const bool bCache = (_eScanEngine != SCANENGINE_COMPARE);
+
+  // Reuse filenames from the last time the file has been scanned
+  if (bCache && _cacheScans.Get(strFile, strPath, result)) return;
+
+  // Parse known formats and scan everything else by brute force
+  const FormatScanner_t *pScanner = FindFormatScanner(strPath, strCheckExt);
+
+  if (pScanner == nullptr || !pScanner->pScan(strPath, result)) {
+    ExtractReferences(strPath, false, _eScanEngine, result.aRefs);
+  }
+
+  if (bCache) _cacheScans.Set(strFile, strPath, result);
+};
+
+// Check if a found dependency can have its own dependencies
+bool CanHaveDependencies(const CString &strFile) {
+  const CString strExt = strFile.GetFileExt().AsLower();
+
+  return strExt == ".mdl" || strExt == ".tex"
+      || strExt == ".smc" || strExt == ".bmf" || strExt == ".ska";
+};
+
+// Check if a file is of a type that can be scanned for dependencies
+bool IsScannableFile(const CString &strFile) {
+  if (CanHaveDependencies(strFile)) return true;
+
+  const CString strExt = strFile.GetFileExt().AsLower();
+
+  for (size_t i = 0; i < _ctFormatScanners; ++i) {
+    if (ExtensionInList(strExt, _aFormatScanners[i].strExts)) return true;
+  }
+
+  return false;
+};
+
+// Add collected dependencies to the list of files to pack
+void MergeDependencies(const ScanResult_t &result) {
+  size_t ctLastFiles = _ctFiles;
+
+  // Apply flags from the file before checking its dependencies
+  _iFlags |= result.iFlags;
+
+  // Report where world dictionaries are
+  if (OnlyDep() && result.world.iDictPos != 0) {
+    std::cout << "(brush dictionary at " << result.world.iBrushes
+      << ", entity dictionary at " << result.world.iEntities << ")\n";
+  }
+
+  for (size_t iExtra = 0; iExtra < result.aExtras.size(); ++iExtra) {
+    AddFile(result.aExtras[iExtra]);
+  }
+
+  // Reuse buffers between filenames
+  CString strFilename;
+  CPathKey key;
+
+  for (size_t iRef = 0; iRef < result.aRefs.size(); ++iRef) {
+    strFilename.assign(result.aRefs[iRef]);
+
+    if (FixFilename(strFilename)) _iFlags |= SCAN_SSR;
+    TryToAddFile(strFilename, key);
+  }
 
   // No dependencies have been added
   if (_ctFiles == ctLastFiles) {
@@ -24,10 +24,52 @@
 
 #include "Main.h"
 
-// Scan the world dictionary for dependencies
-void ScanWorld(const CString &strWorld);
+// Engines for extracting filenames from any file
+enum EScanEngine {
+  SCANENGINE_FAST,    // Search for chunks in a file that's mapped into memory
+  SCANENGINE_STREAM,  // Go through the file one byte at a time via a data stream
+  SCANENGINE_COMPARE, // Run both engines and make sure that their results are identical
+};
 
-// Scan any file for dependencies
-void ScanAnyFile(const CString &strFile, bool bLibrary);
+extern EScanEngine _eScanEngine; // Scanning engine that's currently in use
+
+// Extract raw filenames from any file using a specific engine
+void ExtractReferences(const CString &strPath, bool bLibrary, EScanEngine eEngine, Strings_t &aRefs);
+
+// Positions of dictionaries in a world file
+struct WorldDictionaries_t {
+  u32 iDictPos; // Position of the first DPOS chunk
+  u32 iBrushes; // Offset of the brush textures dictionary
+  u32 iEntities; // Offset of the entity resources dictionary
+  u32 iFlags; // Flags that have been detected from world info
+
+  WorldDictionaries_t() : iDictPos(0), iBrushes(0), iEntities(0), iFlags(0) {};
+};
+
+// Raw dependencies that have been collected from one included file
+struct ScanResult_t {
+  CString strFile; // Included file
+  u32 iFlags; // Flags that have been detected from the file itself
+  Strings_t aExtras; // Files that are packed as is
+  Strings_t aRefs; // Raw filenames that still need to be checked against dependencies
+  CString strError; // Reason why the file couldn't be scanned
+  WorldDictionaries_t world; // Dictionaries of a world file
+  bool bSkipped; // File cannot have any dependencies
+  double dSeconds; // Time spent collecting dependencies
+
+  ScanResult_t() : iFlags(0), bSkipped(false), dSeconds(0.0) {};
+};
+
+// Collect raw dependencies of an included file without modifying any global state
+void CollectDependencies(const CString &strFile, const CString &strPath, ScanResult_t &result);
+
+// Check if a found dependency can have its own dependencies
+bool CanHaveDependencies(const CString &strFile);
+
+// Check if a file is of a type that can be scanned for dependencies
+bool IsScannableFile(const CString &strFile);
+
+// Add collected dependencies to the list of files to pack
+void MergeDependencies(const ScanResult_t &result);
 
 #endif
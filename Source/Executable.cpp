@@ -0,0 +1,165 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Executable.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Read little endian values from any position
+static inline u16 ReadU16(const u8 *p) {
+  return (u16)(p[0] | (p[1] << 8));
+};
+
+static inline u32 ReadU32(const u8 *p) {
+  return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+};
+
+static inline u64 ReadU64(const u8 *p) {
+  return (u64)ReadU32(p) | ((u64)ReadU32(p + 4) << 32);
+};
+
+// Add a range of bytes within the file, clamped by its size
+static void AddFileRange(CFileRanges &aRanges, size_t iStart, size_t iLength, size_t iFileSize) {
+  if (iStart >= iFileSize) return;
+
+  size_t iEnd = iStart + iLength;
+  if (iEnd > iFileSize || iEnd < iStart) iEnd = iFileSize;
+
+  if (iEnd > iStart) {
+    aRanges.push_back(FileRange_t(iStart, iEnd));
+  }
+};
+
+// Sort ranges by their position in the file
+static void SortFileRanges(CFileRanges &aRanges) {
+  std::sort(aRanges.begin(), aRanges.end(), [](const FileRange_t &range1, const FileRange_t &range2) {
+    return range1.iStart < range2.iStart;
+  });
+};
+
+// Find sections of a PE image (.exe, .dll) that may contain string literals
+bool GetLibraryDataPE(const u8 *pData, size_t iSize, CFileRanges &aRanges) {
+  // DOS header with an offset to the PE header
+  if (iSize < 0x40 || pData[0] != 'M' || pData[1] != 'Z') return false;
+
+  const size_t iHeader = ReadU32(pData + 0x3C);
+
+  // PE signature followed by the COFF file header (24 bytes in total)
+  if (iHeader > iSize || iSize - iHeader < 24) return false;
+  if (memcmp(pData + iHeader, "PE\0\0", 4) != 0) return false;
+
+  const size_t ctSections = ReadU16(pData + iHeader + 6);
+  const size_t iOptionalHeaderSize = ReadU16(pData + iHeader + 20);
+
+  // Section table goes right after the optional header
+  const size_t iSections = iHeader + 24 + iOptionalHeaderSize;
+  const size_t iSectionSize = 40;
+
+  if (iSections > iSize || (iSize - iSections) / iSectionSize < ctSections) return false;
+
+  for (size_t iSection = 0; iSection < ctSections; ++iSection) {
+    const u8 *pSection = pData + iSections + iSection * iSectionSize;
+
+    // Section names are padded with null characters up to 8 bytes
+    c8 strName[9];
+    memcpy(strName, pSection, 8);
+    strName[8] = '\0';
+
+    // Only read-only and writable data may have string literals in them
+    // Older compilers put constant strings in ".data" instead of ".rdata"
+    if (strcmp(strName, ".rdata") != 0 && strcmp(strName, ".data") != 0) continue;
+
+    const size_t iRawSize = ReadU32(pSection + 16);
+    const size_t iRawOffset = ReadU32(pSection + 20);
+
+    AddFileRange(aRanges, iRawOffset, iRawSize, iSize);
+  }
+
+  SortFileRanges(aRanges);
+  return true;
+};
+
+// Check if it's a section name that may contain string literals in an ELF image
+static bool IsDataSectionELF(const c8 *strName) {
+  // Compilers may also split constant strings into ".rodata.*" sections
+  return strcmp(strName, ".data") == 0 || strcmp(strName, ".rodata") == 0 || strncmp(strName, ".rodata.", 8) == 0;
+};
+
+// Find sections of an ELF image (.so) that may contain string literals
+bool GetLibraryDataELF(const u8 *pData, size_t iSize, CFileRanges &aRanges) {
+  // Identification bytes
+  if (iSize < 0x34 || memcmp(pData, "\x7F" "ELF", 4) != 0) return false;
+
+  const bool b64 = (pData[4] == 2);
+
+  // Only 32-bit and 64-bit little endian images are supported
+  if ((pData[4] != 1 && !b64) || pData[5] != 1) return false;
+  if (b64 && iSize < 0x40) return false;
+
+  // Section header table
+  const u64 iSections = (b64 ? ReadU64(pData + 0x28) : ReadU32(pData + 0x20));
+  const size_t iSectionSize = ReadU16(pData + (b64 ? 0x3A : 0x2E));
+  const size_t ctSections = ReadU16(pData + (b64 ? 0x3C : 0x30));
+  const size_t iNamesSection = ReadU16(pData + (b64 ? 0x3E : 0x32));
+
+  // Sections are stripped
+  if (iSections == 0 || ctSections == 0 || iNamesSection >= ctSections) return false;
+  if (iSectionSize < (b64 ? 0x40U : 0x28U)) return false;
+  if (iSections > iSize || (iSize - iSections) / iSectionSize < ctSections) return false;
+
+  // Section with names of all sections
+  const u8 *pNames = pData + iSections + iNamesSection * iSectionSize;
+  const u64 iNamesOffset = (b64 ? ReadU64(pNames + 0x18) : ReadU32(pNames + 0x10));
+  const u64 iNamesSize = (b64 ? ReadU64(pNames + 0x20) : ReadU32(pNames + 0x14));
+
+  if (iNamesOffset > iSize || iNamesSize > iSize - iNamesOffset) return false;
+
+  const c8 *strNames = reinterpret_cast<const c8 *>(pData + iNamesOffset);
+
+  for (size_t iSection = 0; iSection < ctSections; ++iSection) {
+    const u8 *pSection = pData + iSections + iSection * iSectionSize;
+
+    // Sections without any bytes in the file (e.g. ".bss")
+    const u32 iType = ReadU32(pSection + 4);
+    if (iType == 0 || iType == 8) continue;
+
+    // Name must be terminated within the section with names
+    const size_t iName = ReadU32(pSection);
+    if (iName >= iNamesSize || memchr(strNames + iName, '\0', (size_t)iNamesSize - iName) == nullptr) continue;
+
+    if (!IsDataSectionELF(strNames + iName)) continue;
+
+    const u64 iOffset = (b64 ? ReadU64(pSection + 0x18) : ReadU32(pSection + 0x10));
+    const u64 iLength = (b64 ? ReadU64(pSection + 0x20) : ReadU32(pSection + 0x14));
+
+    if (iOffset >= iSize) continue;
+    AddFileRange(aRanges, (size_t)iOffset, (size_t)std::min(iLength, (u64)(iSize - iOffset)), iSize);
+  }
+
+  SortFileRanges(aRanges);
+  return true;
+};
+
+// Find sections of any supported executable image that may contain string literals
+bool GetLibraryData(const u8 *pData, size_t iSize, CFileRanges &aRanges) {
+  return GetLibraryDataPE(pData, iSize, aRanges) || GetLibraryDataELF(pData, iSize, aRanges);
+};
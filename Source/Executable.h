@@ -0,0 +1,49 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_EXECUTABLE_H
+#define _DREAMYGRO_INCL_EXECUTABLE_H
+
+#include "Main.h"
+
+// Range of bytes within a file
+struct FileRange_t {
+  size_t iStart;
+  size_t iEnd; // Position right after the last byte
+
+  FileRange_t(size_t iSetStart, size_t iSetEnd) : iStart(iSetStart), iEnd(iSetEnd) {};
+};
+
+typedef std::vector<FileRange_t> CFileRanges;
+
+// Find sections of a PE image (.exe, .dll) that may contain string literals
+// Returns false if it's not a valid PE image
+bool GetLibraryDataPE(const u8 *pData, size_t iSize, CFileRanges &aRanges);
+
+// Find sections of an ELF image (.so) that may contain string literals
+// Returns false if it's not a valid little endian ELF image with a section table
+bool GetLibraryDataELF(const u8 *pData, size_t iSize, CFileRanges &aRanges);
+
+// Find sections of any supported executable image that may contain string literals
+// Returns false if it's not an image of any supported format
+bool GetLibraryData(const u8 *pData, size_t iSize, CFileRanges &aRanges);
+
+#endif
@@ -0,0 +1,294 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "FileSystem.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if _DREAMY_UNIX
+  #include <dirent.h>
+  #include <fcntl.h>
+#else
+  #include <windows.h>
+#endif
+
+CFileIndex _fileIndex;
+
+// Retrieve information about a file and return false if it doesn't exist
+bool GetFileInfo(const CString &strFile, FileInfo_t &info) {
+#if _DREAMY_UNIX
+  struct stat st;
+  if (stat(strFile.c_str(), &st) != 0) return false;
+  if (!S_ISREG(st.st_mode)) return false;
+#else
+  struct _stat64 st;
+  if (_stat64(strFile.c_str(), &st) != 0) return false;
+  if ((st.st_mode & _S_IFREG) == 0) return false;
+#endif
+
+  info.iSize = (u64)st.st_size;
+  info.iTime = (s64)st.st_mtime;
+  return true;
+};
+
+// List files and subdirectories in some directory relative to the root
+static void ListDirectory(const CString &strRoot, const CString &strDir,
+  std::vector<CFileIndex::File_t> &aFiles, Strings_t &aSubdirs)
+{
+  // Other mods are never used
+  const bool bSkipMods = (strDir == "");
+
+#if _DREAMY_UNIX
+  DIR *pDir = opendir((strRoot + strDir).c_str());
+  if (pDir == nullptr) return;
+
+  const int iDir = dirfd(pDir);
+  struct dirent *pEntry;
+
+  while ((pEntry = readdir(pDir)) != nullptr) {
+    const CString strName = pEntry->d_name;
+    if (strName == "." || strName == "..") continue;
+
+    struct stat st;
+    if (fstatat(iDir, pEntry->d_name, &st, 0) != 0) continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      if (!bSkipMods || strName.AsLower() != "mods") aSubdirs.push_back(strDir + strName + "/");
+
+    } else if (S_ISREG(st.st_mode)) {
+      CFileIndex::File_t file;
+      file.strPath = strDir + strName;
+      file.iSize = (u64)st.st_size;
+      aFiles.push_back(file);
+    }
+  }
+
+  closedir(pDir);
+
+#else
+  WIN32_FIND_DATAA data;
+  HANDLE hFind = FindFirstFileA((strRoot + strDir + "*").c_str(), &data);
+  if (hFind == INVALID_HANDLE_VALUE) return;
+
+  do {
+    const CString strName = data.cFileName;
+    if (strName == "." || strName == "..") continue;
+
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      if (!bSkipMods || strName.AsLower() != "mods") aSubdirs.push_back(strDir + strName + "/");
+
+    } else {
+      CFileIndex::File_t file;
+      file.strPath = strDir + strName;
+      file.iSize = ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+      aFiles.push_back(file);
+    }
+  } while (FindNextFileA(hFind, &data));
+
+  FindClose(hFind);
+#endif
+};
+
+// Go through all files under the root and mod directories (excluding other mods) at the same time
+void CFileIndex::Build(const CString &strRoot, const CString &strMod, size_t ctThreads) {
+  Clear();
+  _strRoot = strRoot;
+
+  // Directories that still need to be listed
+  Strings_t aQueue;
+  aQueue.push_back("");
+  if (strMod != "") aQueue.push_back(strMod);
+
+  std::mutex mutex;
+  std::condition_variable cvQueue;
+  size_t ctBusy = 0;
+
+  std::vector<std::vector<File_t> > aThreadFiles(std::max(ctThreads, (size_t)1));
+  std::vector<std::thread> aThreads;
+
+  for (size_t iThread = 0; iThread < aThreadFiles.size(); ++iThread) {
+    std::vector<File_t> &aFiles = aThreadFiles[iThread];
+
+    aThreads.push_back(std::thread([&]() {
+      Strings_t aSubdirs;
+
+      for (;;) {
+        CString strDir;
+
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cvQueue.wait(lock, [&]() { return !aQueue.empty() || ctBusy == 0; });
+
+          // Nothing else to list
+          if (aQueue.empty()) break;
+
+          strDir = aQueue.back();
+          aQueue.pop_back();
+          ++ctBusy;
+        }
+
+        aSubdirs.clear();
+        ListDirectory(_strRoot, strDir, aFiles, aSubdirs);
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          aQueue.insert(aQueue.end(), aSubdirs.begin(), aSubdirs.end());
+          --ctBusy;
+        }
+
+        cvQueue.notify_all();
+      }
+    }));
+  }
+
+  for (size_t iThread = 0; iThread < aThreads.size(); ++iThread) {
+    aThreads[iThread].join();
+  }
+
+  // Gather files from all threads
+  size_t ctFiles = 0;
+
+  for (size_t iThread = 0; iThread < aThreadFiles.size(); ++iThread) {
+    ctFiles += aThreadFiles[iThread].size();
+  }
+
+  _aFiles.reserve(ctFiles);
+  _index.Reserve(ctFiles);
+
+  for (size_t iThread = 0; iThread < aThreadFiles.size(); ++iThread) {
+    const std::vector<File_t> &aFiles = aThreadFiles[iThread];
+
+    for (size_t iFile = 0; iFile < aFiles.size(); ++iFile) {
+      const File_t &file = aFiles[iFile];
+
+      _aFiles.push_back(file);
+      _index.Insert(HashFilenameFolded(file.strPath.c_str(), file.strPath.length()), _aFiles.size() - 1);
+    }
+  }
+
+  _bBuilt = true;
+};
+
+// Forget all files
+void CFileIndex::Clear(void) {
+  _strRoot = "";
+  _aFiles.clear();
+  _index.Clear();
+  _bBuilt = false;
+};
+
+// Find a file by its full path regardless of the case and return nullptr if it's not under the root
+const CFileIndex::File_t *CFileIndex::Find(const CString &strPath, bool &bIndexed) const {
+  const size_t ctRoot = _strRoot.length();
+  bIndexed = _bBuilt && strPath.length() > ctRoot && strPath.compare(0, ctRoot, _strRoot) == 0;
+
+  if (!bIndexed) return nullptr;
+
+  const c8 *strFind = strPath.c_str() + ctRoot;
+  const size_t ctChars = strPath.length() - ctRoot;
+  const std::vector<File_t> &aFiles = _aFiles;
+
+  const size_t iFile = _index.Find(HashFilenameFolded(strFind, ctChars), [&](size_t i) {
+    const CString &strIndexed = aFiles[i].strPath;
+    return strIndexed.length() == ctChars && EqualFolded(strIndexed.c_str(), strFind, ctChars);
+  });
+
+  return (iFile != NULL_POS) ? &_aFiles[iFile] : nullptr;
+};
+
+// Collect paths of all files that match a pattern relative to the root regardless of the case
+void CFileIndex::Match(const CString &strPattern, Strings_t &aPaths) const {
+  for (size_t iFile = 0; iFile < _aFiles.size(); ++iFile) {
+    const CString &strPath = _aFiles[iFile].strPath;
+
+    if (MatchFilePattern(strPattern.c_str(), strPath.c_str())) {
+      aPaths.push_back(strPath);
+    }
+  }
+};
+
+// Check if it's a pattern for multiple files instead of a path to one file
+bool IsFilePattern(const CString &strPattern) {
+  return strPattern.find_first_of("*?") != NULL_POS || (strPattern != "" && strPattern[strPattern.length() - 1] == '/');
+};
+
+// Match a path against a pattern regardless of the case
+bool MatchFilePattern(const c8 *strPattern, const c8 *strPath) {
+  // Position after the last '*' for going back to it
+  const c8 *strStar = nullptr;
+  const c8 *strStarPath = nullptr;
+
+  for (;;) {
+    // Everything under the directory
+    if (strPattern[0] == '/' && strPattern[1] == '\0' && *strPath == '/') return true;
+
+    if (*strPattern == '*') {
+      strStar = ++strPattern;
+      strStarPath = strPath;
+      continue;
+    }
+
+    if (*strPath == '\0') {
+      // Skip trailing stars
+      while (*strPattern == '*') ++strPattern;
+      return *strPattern == '\0';
+    }
+
+    if (*strPattern != '\0' && (FoldChar(*strPattern) == FoldChar(*strPath) || (*strPattern == '?' && *strPath != '/'))) {
+      ++strPattern;
+      ++strPath;
+      continue;
+    }
+
+    // Let the last star match one more character within the same directory
+    if (strStar != nullptr && *strStarPath != '/') {
+      strPattern = strStar;
+      strPath = ++strStarPath;
+      continue;
+    }
+
+    return false;
+  }
+};
+
+// Check if a file exists using the file index if possible and optionally retrieve its path in the actual case
+bool FindFile(const CString &strPath, CString *pstrActualPath) {
+  bool bIndexed;
+  const CFileIndex::File_t *pFile = _fileIndex.Find(strPath, bIndexed);
+
+  // Not under the game directory
+  if (!bIndexed) {
+    if (!FileExists(strPath)) return false;
+
+    if (pstrActualPath != nullptr) *pstrActualPath = strPath;
+    return true;
+  }
+
+  if (pFile == nullptr) return false;
+
+  if (pstrActualPath != nullptr) *pstrActualPath = _fileIndex.Root() + pFile->strPath;
+  return true;
+};
@@ -0,0 +1,91 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_FILESYSTEM_H
+#define _DREAMYGRO_INCL_FILESYSTEM_H
+
+#include "Main.h"
+
+// Basic information about a file on disk
+struct FileInfo_t {
+  u64 iSize;
+  s64 iTime; // Last modification time in seconds since the epoch
+};
+
+// Retrieve information about a file and return false if it doesn't exist
+bool GetFileInfo(const CString &strFile, FileInfo_t &info);
+
+// Check if it's a pattern for multiple files instead of a path to one file
+bool IsFilePattern(const CString &strPattern);
+
+// Match a path against a pattern regardless of the case
+// '*' and '?' apply within one directory and a trailing slash matches everything in a directory and its subdirectories
+bool MatchFilePattern(const c8 *strPattern, const c8 *strPath);
+
+// In-memory list of all files under the game directory
+class CFileIndex {
+  public:
+    // One indexed file
+    struct File_t {
+      CString strPath; // Path relative to the root directory
+      u64 iSize;
+    };
+
+  private:
+    CString _strRoot;
+    std::vector<File_t> _aFiles;
+    CHashIndex _index; // Files by their paths in lowercase
+    bool _bBuilt;
+
+  public:
+    CFileIndex() : _bBuilt(false) {};
+
+    // Go through all files under the root and mod directories (excluding other mods) at the same time
+    void Build(const CString &strRoot, const CString &strMod, size_t ctThreads);
+
+    // Forget all files
+    void Clear(void);
+
+    inline bool IsBuilt(void) const {
+      return _bBuilt;
+    };
+
+    inline size_t Count(void) const {
+      return _aFiles.size();
+    };
+
+    inline const CString &Root(void) const {
+      return _strRoot;
+    };
+
+    // Find a file by its full path regardless of the case and return nullptr if it's not under the root
+    const File_t *Find(const CString &strPath, bool &bIndexed) const;
+
+    // Collect paths of all files that match a pattern relative to the root regardless of the case
+    void Match(const CString &strPattern, Strings_t &aPaths) const;
+};
+
+extern CFileIndex _fileIndex; // Files in the game directory
+
+// Check if a file exists using the file index if possible and optionally retrieve its path in the actual case
+bool FindFile(const CString &strPath, CString *pstrActualPath = nullptr);
+
+#endif
@@ -0,0 +1,721 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "GroArchive.h"
+
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <time.h>
+
+#if _DREAMY_UNIX
+  #include <errno.h>
+  #include <unistd.h>
+
+  #if defined(__linux__)
+    #include <sys/sendfile.h>
+  #endif
+#endif
+
+// Hardware CRC32 that's checked for at runtime on x86 and at compile time on ARM
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #define DREAMYGRO_CRC_PCLMUL 1
+
+  #include <emmintrin.h>
+  #include <wmmintrin.h>
+
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define DREAMYGRO_PCLMUL_TARGET
+  #else
+    #include <cpuid.h>
+    #define DREAMYGRO_PCLMUL_TARGET __attribute__((target("sse2,pclmul")))
+  #endif
+
+#elif defined(__ARM_FEATURE_CRC32)
+  #define DREAMYGRO_CRC_ARM 1
+
+  #include <arm_acle.h>
+#endif
+
+// Signatures of ZIP records
+static const u32 _iLocalHeaderSignature = 0x04034B50;
+static const u32 _iCentralHeaderSignature = 0x02014B50;
+static const u32 _iEndOfCentralDirSignature = 0x06054B50;
+static const u32 _iZip64EndOfCentralDirSignature = 0x06064B50;
+static const u32 _iZip64LocatorSignature = 0x07064B50;
+
+// Extra field for padding stored data (same as the one from zipalign)
+static const u16 _iAlignmentFieldID = 0xD935;
+static const size_t _iAlignmentFieldSize = 6; // Header with the alignment itself
+
+// Version 2.0 that's needed for deflate
+static const u16 _iZipVersion = 20;
+
+// Convert time in seconds since the epoch into MS-DOS format
+void ToDosTime(s64 iTime, u16 &iDosTime, u16 &iDosDate) {
+  time_t tm = (time_t)iTime;
+  struct tm tmLocal;
+
+#if _DREAMY_UNIX
+  const bool bConverted = (localtime_r(&tm, &tmLocal) != nullptr);
+#else
+  const bool bConverted = (localtime_s(&tmLocal, &tm) == 0);
+#endif
+
+  // MS-DOS dates start from 1980
+  if (!bConverted || tmLocal.tm_year < 80) {
+    iDosTime = 0;
+    iDosDate = (1 << 5) | 1; // 1980-01-01
+    return;
+  }
+
+  iDosTime = (u16)((tmLocal.tm_hour << 11) | (tmLocal.tm_min << 5) | (tmLocal.tm_sec >> 1));
+  iDosDate = (u16)(((tmLocal.tm_year - 80) << 9) | ((tmLocal.tm_mon + 1) << 5) | tmLocal.tm_mday);
+};
+
+#if DREAMYGRO_CRC_PCLMUL
+
+// Check if the CPU can multiply without carry
+static bool HasPCLMUL(void) {
+  u32 aRegs[4] = { 0, 0, 0, 0 }; // EAX, EBX, ECX, EDX
+
+#if defined(_MSC_VER)
+  __cpuid((int *)aRegs, 1);
+#else
+  if (!__get_cpuid(1, &aRegs[0], &aRegs[1], &aRegs[2], &aRegs[3])) return false;
+#endif
+
+  return (aRegs[2] & (1 << 1)) != 0;
+};
+
+// Checked once before any threads are started
+static const bool _bPCLMUL = HasPCLMUL();
+
+// Fold data into a bit-reflected CRC32 using carry-less multiplication (from "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" by Intel, same as in Chromium's zlib)
+// Expects at least 64 bytes in multiples of 16 and an inverted CRC
+DREAMYGRO_PCLMUL_TARGET
+static u32 FoldCRC(const u8 *pData, size_t iSize, u32 iCRC) {
+  static const u64 _aK1K2[2] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+  static const u64 _aK3K4[2] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+  static const u64 _aK5K0[2] = { 0x0163cd6124ULL, 0x0000000000ULL };
+  static const u64 _aPoly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  // First block of 64 bytes
+  x1 = _mm_loadu_si128((const __m128i *)(pData + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *)(pData + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(pData + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(pData + 0x30));
+
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)iCRC));
+  x0 = _mm_loadu_si128((const __m128i *)_aK1K2);
+
+  pData += 64;
+  iSize -= 64;
+
+  // Fold the next blocks of 64 bytes in parallel
+  while (iSize >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(pData + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(pData + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(pData + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(pData + 0x30)));
+
+    pData += 64;
+    iSize -= 64;
+  }
+
+  // Fold four values into one
+  x0 = _mm_loadu_si128((const __m128i *)_aK3K4);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // Fold the remaining blocks of 16 bytes
+  while (iSize >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)pData)), x5);
+
+    pData += 16;
+    iSize -= 16;
+  }
+
+  // Fold 128 bits into 64 bits
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+  x0 = _mm_loadl_epi64((const __m128i *)_aK5K0);
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, x3), x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction into 32 bits
+  x0 = _mm_loadu_si128((const __m128i *)_aPoly);
+
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, x3), x0, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, x3), x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Second 32-bit value without SSE4.1
+  return (u32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+};
+
+#elif DREAMYGRO_CRC_ARM
+
+// Compute CRC32 using ARMv8 instructions (expects an inverted CRC)
+static u32 FoldCRC(const u8 *pData, size_t iSize, u32 iCRC) {
+  for (; iSize >= 8; pData += 8, iSize -= 8) {
+    u64 iValue;
+    memcpy(&iValue, pData, 8);
+    iCRC = __crc32d(iCRC, iValue);
+  }
+
+  for (; iSize > 0; ++pData, --iSize) {
+    iCRC = __crc32b(iCRC, *pData);
+  }
+
+  return iCRC;
+};
+
+#endif
+
+// Continue computing CRC32 of some data (starting from 0)
+u32 ComputeCRC(u32 iCRC, const void *pData, size_t iSize) {
+  const Bytef *pBytes = (const Bytef *)pData;
+
+#if DREAMYGRO_CRC_PCLMUL
+  // Fold whole blocks in hardware and leave the rest to zlib
+  if (_bPCLMUL && iSize >= 64) {
+    const size_t ctFolded = iSize & ~(size_t)15;
+
+    iCRC = ~FoldCRC(pBytes, ctFolded, ~iCRC);
+    pBytes += ctFolded;
+    iSize -= ctFolded;
+  }
+
+#elif DREAMYGRO_CRC_ARM
+  return ~FoldCRC(pBytes, iSize, ~iCRC);
+#endif
+
+  // Process in chunks that fit into zlib's integer type
+  while (iSize > 0) {
+    const uInt ctChunk = (uInt)std::min(iSize, (size_t)0x40000000);
+
+    iCRC = (u32)crc32(iCRC, pBytes, ctChunk);
+    pBytes += ctChunk;
+    iSize -= ctChunk;
+  }
+
+  return iCRC;
+};
+
+// Read little endian values from memory
+static inline u16 ReadU16(const u8 *p) {
+  return (u16)(p[0] | (p[1] << 8));
+};
+
+static inline u32 ReadU32(const u8 *p) {
+  return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+};
+
+static inline u64 ReadU64(const u8 *p) {
+  return (u64)ReadU32(p) | ((u64)ReadU32(p + 4) << 32);
+};
+
+// Map the archive and find its central directory
+bool CGroDirectory::Open(const CString &strFile) {
+  Close();
+
+  if (!_file.Open(strFile)) return false;
+
+  const u8 *pData = _file.Data();
+  const size_t iSize = _file.Size();
+
+  // Find the end of the central directory that may be followed by a comment
+  const size_t iEndRecordSize = 22;
+
+  if (iSize < iEndRecordSize) {
+    Close();
+    return false;
+  }
+
+  const size_t iSearchLimit = (iSize > 0xFFFF + iEndRecordSize) ? iSize - 0xFFFF - iEndRecordSize : 0;
+  size_t iEndRecord = iSize - iEndRecordSize;
+
+  while (ReadU32(pData + iEndRecord) != _iEndOfCentralDirSignature) {
+    // No central directory
+    if (iEndRecord == iSearchLimit) {
+      Close();
+      return false;
+    }
+
+    --iEndRecord;
+  }
+
+  _ctEntries = ReadU16(pData + iEndRecord + 10);
+  u64 iDirOffset = ReadU32(pData + iEndRecord + 16);
+  _iDirEnd = iEndRecord;
+
+  // ZIP64 locator may be right before the end record
+  const size_t iLocatorSize = 20;
+  const size_t iZip64RecordSize = 56;
+
+  if ((_ctEntries == 0xFFFF || iDirOffset == 0xFFFFFFFF) && iEndRecord >= iLocatorSize
+   && ReadU32(pData + iEndRecord - iLocatorSize) == _iZip64LocatorSignature)
+  {
+    const u64 iZip64Record = ReadU64(pData + iEndRecord - iLocatorSize + 8);
+
+    if (iZip64Record + iZip64RecordSize <= iEndRecord - iLocatorSize
+     && ReadU32(pData + (size_t)iZip64Record) == _iZip64EndOfCentralDirSignature)
+    {
+      const u8 *pRecord = pData + (size_t)iZip64Record;
+      _ctEntries = ReadU64(pRecord + 32);
+      iDirOffset = ReadU64(pRecord + 48);
+      _iDirEnd = (size_t)iZip64Record;
+    }
+  }
+
+  if (iDirOffset > _iDirEnd) {
+    Close();
+    return false;
+  }
+
+  _iDirStart = (size_t)iDirOffset;
+  _iRecord = _iDirStart;
+  return true;
+};
+
+// Unmap the archive
+void CGroDirectory::Close(void) {
+  _file.Close();
+
+  _iDirStart = _iDirEnd = 0;
+  _ctEntries = 0;
+  _iRecord = 0;
+  _iEntry = 0;
+  _bBroken = false;
+};
+
+// Get the next record or nullptr if there are no more valid records
+const u8 *CGroDirectory::NextRecord(void) {
+  if (_bBroken || _iEntry >= _ctEntries) return nullptr;
+
+  const u8 *pRecord = _file.Data() + _iRecord;
+
+  // Reached the end too early or not a record
+  if (_iRecord + 46 > _iDirEnd || ReadU32(pRecord) != _iCentralHeaderSignature) {
+    _bBroken = true;
+    return nullptr;
+  }
+
+  // Name, extra field and comment
+  const size_t iRecordSize = 46 + ReadU16(pRecord + 28) + ReadU16(pRecord + 30) + ReadU16(pRecord + 32);
+
+  if (_iRecord + iRecordSize > _iDirEnd) {
+    _bBroken = true;
+    return nullptr;
+  }
+
+  _iRecord += iRecordSize;
+  ++_iEntry;
+
+  return pRecord;
+};
+
+// Get name of the next entry and return false if there are no more valid records
+bool CGroDirectory::NextName(const c8 *&strName, size_t &ctChars) {
+  const u8 *pRecord = NextRecord();
+  if (pRecord == nullptr) return false;
+
+  strName = (const c8 *)pRecord + 46;
+  ctChars = ReadU16(pRecord + 28);
+  return true;
+};
+
+// Open an archive and read its central directory
+bool CGroReader::Open(const CString &strFile) {
+  Close();
+
+  if (!_dir.Open(strFile)) return false;
+
+  const size_t ctEntries = (size_t)std::min(_dir.Count(), (u64)0x10000000);
+  _aEntries.reserve(ctEntries);
+  _index.Reserve(ctEntries);
+
+  const u8 *pRecord;
+
+  while ((pRecord = _dir.NextRecord()) != nullptr) {
+    const size_t ctNameChars = ReadU16(pRecord + 28);
+
+    GroEntry_t entry;
+    entry.strName = CString((const c8 *)pRecord + 46, ctNameChars);
+    entry.iFlags = ReadU16(pRecord + 8);
+    entry.iMethod = ReadU16(pRecord + 10);
+    entry.iTime = ReadU16(pRecord + 12);
+    entry.iDate = ReadU16(pRecord + 14);
+    entry.iCRC = ReadU32(pRecord + 16);
+    entry.iPackedSize = ReadU32(pRecord + 20);
+    entry.iSize = ReadU32(pRecord + 24);
+    entry.iOffset = ReadU32(pRecord + 42);
+
+    _aEntries.push_back(entry);
+    _index.Insert(HashFilenameFolded(entry.strName.c_str(), ctNameChars), _aEntries.size() - 1);
+  }
+
+  // Broken central directory
+  if (_dir.IsBroken()) {
+    Close();
+    return false;
+  }
+
+  return true;
+};
+
+// Close the archive
+void CGroReader::Close(void) {
+  _dir.Close();
+  _aEntries.clear();
+  _index.Clear();
+};
+
+// Find index of an entry by its name regardless of the case
+size_t CGroReader::Find(const CString &strName) const {
+  const c8 *strFind = strName.c_str();
+  const size_t ctChars = strName.length();
+  const std::vector<GroEntry_t> &aEntries = _aEntries;
+
+  return _index.Find(HashFilenameFolded(strFind, ctChars), [&](size_t iEntry) {
+    const CString &strEntry = aEntries[iEntry].strName;
+    return strEntry.length() == ctChars && EqualFolded(strEntry.c_str(), strFind, ctChars);
+  });
+};
+
+// Get compressed data of an entry or nullptr if it lies outside the archive
+const u8 *CGroReader::GetData(const GroEntry_t &entry) const {
+  const u8 *pData = _dir.Data();
+  const size_t iSize = _dir.Size();
+  const size_t iHeader = entry.iOffset;
+
+  if (iHeader + 30 > iSize || ReadU32(pData + iHeader) != _iLocalHeaderSignature) return nullptr;
+
+  // Local header may have a different extra field than the central directory
+  const size_t iData = iHeader + 30 + ReadU16(pData + iHeader + 26) + ReadU16(pData + iHeader + 28);
+  if (iData > iSize || iSize - iData < entry.iPackedSize) return nullptr;
+
+  return pData + iData;
+};
+
+CSourceArchives _groSources;
+
+// Open another archive and return false if it cannot be read
+bool CSourceArchives::Add(const CString &strFile) {
+  std::shared_ptr<CGroReader> pArchive(new CGroReader);
+  if (!pArchive->Open(strFile)) return false;
+
+  _aArchives.push_back(pArchive);
+  _aPaths.push_back(strFile);
+  return true;
+};
+
+// Close all archives
+void CSourceArchives::Clear(void) {
+  _aArchives.clear();
+  _aPaths.clear();
+};
+
+// Find an entry that can be copied as is in the first archive that has it
+const GroEntry_t *CSourceArchives::Find(const CString &strName, const u8 **ppData, CString *pstrArchive) const {
+  for (size_t iArchive = 0; iArchive < _aArchives.size(); ++iArchive) {
+    const CGroReader &gro = *_aArchives[iArchive];
+
+    const size_t iEntry = gro.Find(strName);
+    if (iEntry == NULL_POS) continue;
+
+    const GroEntry_t &entry = gro[iEntry];
+
+    // Skip encrypted entries, unsupported methods and ZIP64 entries
+    if ((entry.iFlags & 1) || (entry.iMethod != GROMETHOD_STORE && entry.iMethod != GROMETHOD_DEFLATE)
+     || entry.iSize == 0xFFFFFFFF || entry.iPackedSize == 0xFFFFFFFF) {
+      continue;
+    }
+
+    const u8 *pData = gro.GetData(entry);
+    if (pData == nullptr) continue;
+
+    if (ppData != nullptr) *ppData = pData;
+    if (pstrArchive != nullptr) *pstrArchive = _aPaths[iArchive];
+    return &entry;
+  }
+
+  return nullptr;
+};
+
+CGroWriter::CGroWriter() : _pFile(nullptr), _iPos(0), _iAlignment(0)
+{
+};
+
+CGroWriter::~CGroWriter() {
+  if (_pFile != nullptr) {
+    fclose(_pFile);
+  }
+};
+
+// Create a new archive file
+void CGroWriter::Create(const CString &strFile) {
+  _pFile = fopen(strFile.c_str(), "wb");
+
+  if (_pFile == nullptr) {
+    throw std::runtime_error("Cannot create the archive");
+  }
+
+  _strFile = strFile;
+  _iPos = 0;
+  _aEntries.clear();
+};
+
+// Write raw data at the current position
+void CGroWriter::Write(const void *pData, size_t iSize) {
+  if (iSize == 0) return;
+
+  if (fwrite(pData, 1, iSize, _pFile) != iSize) {
+    throw std::runtime_error("Cannot write to the archive");
+  }
+
+  _iPos += iSize;
+};
+
+// Write little endian values
+void CGroWriter::WriteU16(u16 iValue) {
+  const u8 aBytes[2] = { (u8)iValue, (u8)(iValue >> 8) };
+  Write(aBytes, 2);
+};
+
+void CGroWriter::WriteU32(u32 iValue) {
+  const u8 aBytes[4] = { (u8)iValue, (u8)(iValue >> 8), (u8)(iValue >> 16), (u8)(iValue >> 24) };
+  Write(aBytes, 4);
+};
+
+// Write local header of an entry at the current position and set its offset
+void CGroWriter::WriteLocalHeader(GroEntry_t &entry) {
+  // Serious Engine cannot read ZIP64 archives
+  if (_iPos > 0xFFFFFFFF) {
+    throw std::runtime_error("The archive cannot be bigger than 4 GB");
+  }
+
+  entry.iOffset = (u32)_iPos;
+
+  WriteU32(_iLocalHeaderSignature);
+  WriteU16(_iZipVersion);
+  WriteU16(entry.iFlags);
+  WriteU16(entry.iMethod);
+  WriteU16(entry.iTime);
+  WriteU16(entry.iDate);
+  WriteU32(entry.iCRC);
+  WriteU32(entry.iPackedSize);
+  WriteU32(entry.iSize);
+  WriteU16((u16)entry.strName.length());
+
+  // Pad the extra field so that stored data starts at an aligned position
+  size_t ctPadding = 0;
+
+  if (_iAlignment > 1 && entry.iMethod == GROMETHOD_STORE) {
+    const u64 iData = _iPos + 2 + entry.strName.length();
+    ctPadding = (size_t)((_iAlignment - iData % _iAlignment) % _iAlignment);
+
+    // Extra field needs space for its own header
+    while (ctPadding != 0 && ctPadding < _iAlignmentFieldSize) {
+      ctPadding += _iAlignment;
+    }
+  }
+
+  WriteU16((u16)ctPadding); // Extra field length
+  Write(entry.strName.c_str(), entry.strName.length());
+
+  if (ctPadding != 0) {
+    WriteU16(_iAlignmentFieldID);
+    WriteU16((u16)(ctPadding - 4));
+    WriteU16((u16)_iAlignment);
+
+    // Fill the rest with zeros
+    static const u8 _aZeros[256] = { 0 };
+
+    for (size_t ctLeft = ctPadding - _iAlignmentFieldSize; ctLeft != 0;) {
+      const size_t ctWrite = std::min(ctLeft, sizeof(_aZeros));
+      Write(_aZeros, ctWrite);
+      ctLeft -= ctWrite;
+    }
+  }
+};
+
+// Write an entry with its data (already compressed using the entry's method) and set its offset
+void CGroWriter::AddEntry(GroEntry_t &entry, const void *pData) {
+  WriteLocalHeader(entry);
+  Write(pData, entry.iPackedSize);
+
+  _aEntries.push_back(entry);
+};
+
+// Write a stored entry by copying contents of the file directly into the archive and set its offset
+void CGroWriter::AddStoredEntry(GroEntry_t &entry, const CMappedFile &file) {
+  WriteLocalHeader(entry);
+
+  size_t iCopied = 0;
+
+#if _DREAMY_UNIX && defined(__linux__)
+  // Let the kernel copy file contents without passing them through the program
+  if (file.Descriptor() != -1 && entry.iPackedSize != 0) {
+    if (fflush(_pFile) != 0) {
+      throw std::runtime_error("Cannot write to the archive");
+    }
+
+    const int iArchive = fileno(_pFile);
+    loff_t iOffset = 0;
+    bool bSendFile = false;
+
+    while (iCopied < entry.iPackedSize) {
+      const size_t ctLeft = entry.iPackedSize - iCopied;
+      ssize_t ctWritten;
+
+      if (!bSendFile) {
+        ctWritten = copy_file_range(file.Descriptor(), &iOffset, iArchive, nullptr, ctLeft, 0);
+
+        // Not supported between these files (some filesystems report it by not copying anything)
+        if (ctWritten == 0 || (ctWritten == -1 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))) {
+          bSendFile = true;
+          continue;
+        }
+
+      } else {
+        off_t iSendOffset = (off_t)iOffset;
+        ctWritten = sendfile(iArchive, file.Descriptor(), &iSendOffset, ctLeft);
+
+        if (ctWritten > 0) iOffset = iSendOffset;
+      }
+
+      if (ctWritten == -1 && errno == EINTR) continue;
+
+      // Write the rest from memory if neither of them can copy it
+      if (ctWritten <= 0) break;
+
+      iCopied += (size_t)ctWritten;
+    }
+
+    _iPos += iCopied;
+  }
+#endif
+
+  // Write the rest from memory
+  if (iCopied < entry.iPackedSize) {
+    Write(file.Data() + iCopied, entry.iPackedSize - iCopied);
+  }
+
+  _aEntries.push_back(entry);
+};
+
+// Write the central directory and close the archive
+void CGroWriter::Finish(void) {
+  const u64 iDirOffset = _iPos;
+  const size_t ctEntries = _aEntries.size();
+
+  if (iDirOffset > 0xFFFFFFFF || ctEntries > 0xFFFF) {
+    throw std::runtime_error("Too much data for one archive");
+  }
+
+  for (size_t i = 0; i < ctEntries; ++i) {
+    const GroEntry_t &entry = _aEntries[i];
+
+    WriteU32(_iCentralHeaderSignature);
+    WriteU16(_iZipVersion); // Made by MS-DOS compatible system
+    WriteU16(_iZipVersion);
+    WriteU16(entry.iFlags);
+    WriteU16(entry.iMethod);
+    WriteU16(entry.iTime);
+    WriteU16(entry.iDate);
+    WriteU32(entry.iCRC);
+    WriteU32(entry.iPackedSize);
+    WriteU32(entry.iSize);
+    WriteU16((u16)entry.strName.length());
+    WriteU16(0); // Extra field length
+    WriteU16(0); // Comment length
+    WriteU16(0); // Disk number
+    WriteU16(0); // Internal attributes
+    WriteU32(0); // External attributes
+    WriteU32(entry.iOffset);
+    Write(entry.strName.c_str(), entry.strName.length());
+  }
+
+  const u64 iDirSize = _iPos - iDirOffset;
+
+  WriteU32(_iEndOfCentralDirSignature);
+  WriteU16(0); // Disk number
+  WriteU16(0); // Disk with the central directory
+  WriteU16((u16)ctEntries);
+  WriteU16((u16)ctEntries);
+  WriteU32((u32)iDirSize);
+  WriteU32((u32)iDirOffset);
+  WriteU16(0); // Comment length
+
+  const bool bClosed = (fclose(_pFile) == 0);
+  _pFile = nullptr;
+
+  if (!bClosed) {
+    throw std::runtime_error("Cannot finish writing the archive");
+  }
+};
+
+// Close an unfinished archive and delete it
+void CGroWriter::Discard(void) {
+  if (_pFile != nullptr) {
+    fclose(_pFile);
+    _pFile = nullptr;
+  }
+
+  if (_strFile != "") {
+    remove(_strFile.c_str());
+    _strFile = "";
+  }
+};
@@ -0,0 +1,207 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_GROARCHIVE_H
+#define _DREAMYGRO_INCL_GROARCHIVE_H
+
+#include "Main.h"
+#include "MappedFile.h"
+
+#include <memory>
+#include <stdio.h>
+
+// Compression methods of entries that Serious Engine can read
+enum EGroMethod {
+  GROMETHOD_STORE   = 0,
+  GROMETHOD_DEFLATE = 8,
+};
+
+// Entry in a GRO archive
+struct GroEntry_t {
+  CString strName; // Full path inside the archive
+  u16 iFlags;      // General purpose flags
+  u16 iMethod;     // Compression method
+  u16 iTime;       // Last modification time in MS-DOS format
+  u16 iDate;       // Last modification date in MS-DOS format
+  u32 iCRC;        // CRC32 of uncompressed data
+  u32 iPackedSize; // Size of compressed data
+  u32 iSize;       // Size of uncompressed data
+  u32 iOffset;     // Offset of the local header from the beginning of the archive
+
+  GroEntry_t() : iFlags(0), iMethod(GROMETHOD_STORE), iTime(0), iDate(0), iCRC(0), iPackedSize(0), iSize(0), iOffset(0) {};
+};
+
+// Convert time in seconds since the epoch into MS-DOS format
+void ToDosTime(s64 iTime, u16 &iDosTime, u16 &iDosDate);
+
+// Continue computing CRC32 of some data (starting from 0)
+u32 ComputeCRC(u32 iCRC, const void *pData, size_t iSize);
+
+// Walker over records in the central directory of an archive without reading anything else
+class CGroDirectory {
+  private:
+    CMappedFile _file;
+    size_t _iDirStart; // First record
+    size_t _iDirEnd; // Position right after the last record
+    u64 _ctEntries;
+
+    size_t _iRecord; // Current record
+    u64 _iEntry; // Current entry
+    bool _bBroken; // Encountered invalid records
+
+  public:
+    CGroDirectory() : _iDirStart(0), _iDirEnd(0), _ctEntries(0), _iRecord(0), _iEntry(0), _bBroken(false) {};
+
+    // Map the archive and find its central directory
+    bool Open(const CString &strFile);
+
+    // Unmap the archive
+    void Close(void);
+
+    // Amount of entries according to the end of the central directory
+    inline u64 Count(void) const {
+      return _ctEntries;
+    };
+
+    // Check if some record has been invalid
+    inline bool IsBroken(void) const {
+      return _bBroken;
+    };
+
+    // Entire archive in memory
+    inline const u8 *Data(void) const {
+      return _file.Data();
+    };
+
+    inline size_t Size(void) const {
+      return _file.Size();
+    };
+
+    // Get the next record or nullptr if there are no more valid records
+    const u8 *NextRecord(void);
+
+    // Get name of the next entry and return false if there are no more valid records
+    bool NextName(const c8 *&strName, size_t &ctChars);
+};
+
+// Read-only view of an existing GRO archive
+class CGroReader {
+  private:
+    CGroDirectory _dir;
+    std::vector<GroEntry_t> _aEntries;
+    CHashIndex _index; // Case insensitive index of entry names
+
+  public:
+    // Open an archive and read its central directory
+    bool Open(const CString &strFile);
+
+    // Close the archive
+    void Close(void);
+
+    // Amount of entries in the archive
+    inline size_t Count(void) const {
+      return _aEntries.size();
+    };
+
+    inline const GroEntry_t &operator[](size_t i) const {
+      return _aEntries[i];
+    };
+
+    // Find index of an entry by its name regardless of the case
+    size_t Find(const CString &strName) const;
+
+    // Get compressed data of an entry or nullptr if it lies outside the archive
+    const u8 *GetData(const GroEntry_t &entry) const;
+};
+
+// Existing archives that entries can be copied from without recompressing them
+class CSourceArchives {
+  private:
+    std::vector<std::shared_ptr<CGroReader> > _aArchives;
+    Strings_t _aPaths;
+
+  public:
+    // Open another archive and return false if it cannot be read
+    bool Add(const CString &strFile);
+
+    // Close all archives
+    void Clear(void);
+
+    inline size_t Count(void) const {
+      return _aArchives.size();
+    };
+
+    // Find an entry that can be copied as is in the first archive that has it
+    const GroEntry_t *Find(const CString &strName, const u8 **ppData = nullptr, CString *pstrArchive = nullptr) const;
+};
+
+extern CSourceArchives _groSources; // Archives with files that aren't on disk
+
+// Sequential writer of GRO archives
+class CGroWriter {
+  private:
+    FILE *_pFile;
+    CString _strFile; // Path to the archive that's being written
+    u64 _iPos; // Current position in the archive
+    u32 _iAlignment; // Alignment of data of stored entries
+    std::vector<GroEntry_t> _aEntries;
+
+  public:
+    CGroWriter();
+    ~CGroWriter();
+
+    // Create a new archive file
+    void Create(const CString &strFile);
+
+    // Start data of all stored entries at positions that are multiples of some amount of bytes (up to 32 KB)
+    inline void SetAlignment(u32 iAlignment) {
+      _iAlignment = iAlignment;
+    };
+
+    // Write an entry with its data (already compressed using the entry's method) and set its offset
+    void AddEntry(GroEntry_t &entry, const void *pData);
+
+    // Write a stored entry by copying contents of the file directly into the archive and set its offset
+    void AddStoredEntry(GroEntry_t &entry, const CMappedFile &file);
+
+    // Write the central directory and close the archive
+    void Finish(void);
+
+    // Close an unfinished archive and delete it
+    void Discard(void);
+
+  private:
+    // Write local header of an entry at the current position and set its offset
+    void WriteLocalHeader(GroEntry_t &entry);
+
+    // Write raw data at the current position
+    void Write(const void *pData, size_t iSize);
+
+    // Write little endian values
+    void WriteU16(u16 iValue);
+    void WriteU32(u32 iValue);
+
+    // Disallow copying
+    CGroWriter(const CGroWriter &);
+    CGroWriter &operator=(const CGroWriter &);
+};
+
+#endif
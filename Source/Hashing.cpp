@@ -0,0 +1,170 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Hashing.h"
+#include "StringArena.h"
+
+#include <string.h>
+
+// Remove all elements
+void CHashIndex::Clear(void) {
+  _aSlots.clear();
+  _ctElements = 0;
+};
+
+// Make enough slots for a specific amount of elements
+void CHashIndex::Reserve(size_t ctElements) {
+  // Keep the table at most 3/4 full
+  const size_t ctMinSlots = ctElements + ctElements / 3 + 1;
+  size_t ctSlots = 16;
+
+  while (ctSlots < ctMinSlots) {
+    ctSlots <<= 1;
+  }
+
+  if (ctSlots > _aSlots.size()) {
+    Rehash(ctSlots);
+  }
+};
+
+// Add element under some hash without checking for duplicates
+void CHashIndex::Insert(u64 iHash, size_t iElement) {
+  Reserve(_ctElements + 1);
+
+  const size_t iMask = _aSlots.size() - 1;
+  size_t iSlot = SlotFromHash(iHash) & iMask;
+
+  // Find the first empty slot
+  while (_aSlots[iSlot].iElement != NULL_POS) {
+    iSlot = (iSlot + 1) & iMask;
+  }
+
+  Slot_t &slot = _aSlots[iSlot];
+  slot.iHash = iHash;
+  slot.iElement = iElement;
+
+  ++_ctElements;
+};
+
+// Move all elements into a new array of slots
+void CHashIndex::Rehash(size_t ctSlots) {
+  std::vector<Slot_t> aOldSlots;
+  aOldSlots.swap(_aSlots);
+
+  Slot_t slotEmpty;
+  slotEmpty.iHash = 0;
+  slotEmpty.iElement = NULL_POS;
+
+  _aSlots.assign(ctSlots, slotEmpty);
+  _ctElements = 0;
+
+  const size_t iMask = ctSlots - 1;
+
+  for (size_t i = 0; i < aOldSlots.size(); ++i) {
+    const Slot_t &slotOld = aOldSlots[i];
+    if (slotOld.iElement == NULL_POS) continue;
+
+    size_t iSlot = SlotFromHash(slotOld.iHash) & iMask;
+
+    while (_aSlots[iSlot].iElement != NULL_POS) {
+      iSlot = (iSlot + 1) & iMask;
+    }
+
+    _aSlots[iSlot] = slotOld;
+    ++_ctElements;
+  }
+};
+
+// Remove all filenames
+void CDependencySet::Clear(void) {
+  _aKeys.clear();
+  _index.Clear();
+};
+
+// Make enough space for a specific amount of filenames
+void CDependencySet::Reserve(size_t ctKeys) {
+  _aKeys.reserve(ctKeys);
+  _index.Reserve(ctKeys);
+};
+
+// Find index of a key and optionally compare it case-insensitively
+size_t CDependencySet::Find(u64 iHash, const c8 *strKey, size_t ctChars, bool bFolded) const {
+  const std::vector<Key_t> &aKeys = _aKeys;
+
+  // Compare full keys in case different filenames end up with the same hash
+  return _index.Find(iHash, [&](size_t iKey) {
+    const Key_t &key = aKeys[iKey];
+    if (key.ctLength != ctChars) return false;
+
+    const c8 *strStored = key.strKey;
+
+    if (bFolded) {
+      return EqualFolded(strStored, strKey, ctChars);
+    }
+
+    return memcmp(strStored, strKey, ctChars) == 0;
+  });
+};
+
+// Append a new key under some hash
+void CDependencySet::Insert(u64 iHash, const c8 *strKey, size_t ctChars, bool bFold) {
+  // Share the same copy with other users of the filename
+  const CName name = (bFold ? _arenaNames.InternFolded(strKey, ctChars, iHash) : _arenaNames.Intern(strKey, ctChars, iHash));
+
+  Key_t key;
+  key.strKey = name.c_str();
+  key.ctLength = name.length();
+
+  _aKeys.push_back(key);
+  _index.Insert(iHash, _aKeys.size() - 1);
+};
+
+// Check if the filename is in the set
+bool CDependencySet::Contains(const c8 *strKey, size_t ctChars) const {
+  return Find(HashFilename(strKey, ctChars), strKey, ctChars) != NULL_POS;
+};
+
+// Check if the filename with an already computed HashFilename() is in the set
+bool CDependencySet::Contains(const c8 *strKey, size_t ctChars, u64 iHash) const {
+  return Find(iHash, strKey, ctChars) != NULL_POS;
+};
+
+// Add filename to the set and return true if it wasn't there before
+bool CDependencySet::Add(const c8 *strKey, size_t ctChars) {
+  const u64 iHash = HashFilename(strKey, ctChars);
+
+  // Already in there
+  if (Find(iHash, strKey, ctChars) != NULL_POS) return false;
+
+  Insert(iHash, strKey, ctChars, false);
+  return true;
+};
+
+// Add filename in lowercase without making a lowercase copy of it first
+bool CDependencySet::AddFolded(const c8 *strKey, size_t ctChars) {
+  const u64 iHash = HashFilenameFolded(strKey, ctChars);
+
+  // Already in there
+  if (Find(iHash, strKey, ctChars, true) != NULL_POS) return false;
+
+  Insert(iHash, strKey, ctChars, true);
+  return true;
+};
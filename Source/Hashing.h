@@ -0,0 +1,176 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_HASHING_H
+#define _DREAMYGRO_INCL_HASHING_H
+
+#include <DreamyUtilities/Types/Arrays.hpp>
+
+using namespace dreamy;
+
+#include <vector>
+
+// Stable 64-bit hash of a filename (FNV-1a), independent of the platform and the standard library
+inline u64 HashFilename(const c8 *strFilename, size_t ctChars) {
+  u64 iHash = 14695981039346656037ULL;
+
+  for (size_t i = 0; i < ctChars; ++i) {
+    iHash ^= (u8)strFilename[i];
+    iHash *= 1099511628211ULL;
+  }
+
+  return iHash;
+};
+
+inline u64 HashFilename(const CString &strFilename) {
+  return HashFilename(strFilename.c_str(), strFilename.length());
+};
+
+// Lowercase ASCII character
+inline c8 FoldChar(c8 ch) {
+  return (ch >= 'A' && ch <= 'Z') ? (c8)(ch - 'A' + 'a') : ch;
+};
+
+// Same hash as HashFilename() of a lowercase filename but without making a lowercase copy
+inline u64 HashFilenameFolded(const c8 *strFilename, size_t ctChars) {
+  u64 iHash = 14695981039346656037ULL;
+
+  for (size_t i = 0; i < ctChars; ++i) {
+    iHash ^= (u8)FoldChar(strFilename[i]);
+    iHash *= 1099511628211ULL;
+  }
+
+  return iHash;
+};
+
+// Case insensitive comparison of two filenames
+inline bool EqualFolded(const c8 *str1, const c8 *str2, size_t ctChars) {
+  for (size_t i = 0; i < ctChars; ++i) {
+    if (FoldChar(str1[i]) != FoldChar(str2[i])) return false;
+  }
+
+  return true;
+};
+
+// Open addressing table of hashes that point to elements of some external array
+class CHashIndex {
+  private:
+    struct Slot_t {
+      u64 iHash;
+      size_t iElement; // NULL_POS if the slot is empty
+    };
+
+    std::vector<Slot_t> _aSlots; // Amount of slots is always a power of two
+    size_t _ctElements;
+
+  public:
+    CHashIndex() : _ctElements(0) {};
+
+    // Remove all elements
+    void Clear(void);
+
+    // Make enough slots for a specific amount of elements
+    void Reserve(size_t ctElements);
+
+    // Add element under some hash without checking for duplicates
+    void Insert(u64 iHash, size_t iElement);
+
+    // Find index of an element with the same hash that satisfies the comparison function
+    template<class Equal> inline
+    size_t Find(u64 iHash, const Equal &funcEqual) const {
+      if (_aSlots.empty()) return NULL_POS;
+
+      const size_t iMask = _aSlots.size() - 1;
+      size_t iSlot = SlotFromHash(iHash) & iMask;
+
+      // Go through the chain of slots until an empty one
+      for (;;) {
+        const Slot_t &slot = _aSlots[iSlot];
+
+        if (slot.iElement == NULL_POS) return NULL_POS;
+        if (slot.iHash == iHash && funcEqual(slot.iElement)) return slot.iElement;
+
+        iSlot = (iSlot + 1) & iMask;
+      }
+    };
+
+  private:
+    // Mix upper bits of the hash into the slot index
+    static inline size_t SlotFromHash(u64 iHash) {
+      return (size_t)(iHash ^ (iHash >> 32));
+    };
+
+    // Move all elements into a new array of slots
+    void Rehash(size_t ctSlots);
+};
+
+// Set of lowercase filenames that are stored in the arena with names of all dependencies
+class CDependencySet {
+  private:
+    struct Key_t {
+      const c8 *strKey;
+      size_t ctLength;
+    };
+
+    std::vector<Key_t> _aKeys;
+    CHashIndex _index;
+
+  public:
+    // Remove all filenames
+    void Clear(void);
+
+    // Make enough space for a specific amount of filenames
+    void Reserve(size_t ctKeys);
+
+    // Amount of filenames in the set
+    inline size_t Size(void) const {
+      return _aKeys.size();
+    };
+
+    // Check if the filename is in the set
+    bool Contains(const c8 *strKey, size_t ctChars) const;
+
+    inline bool Contains(const CString &strKey) const {
+      return Contains(strKey.c_str(), strKey.length());
+    };
+
+    // Check if the filename with an already computed HashFilename() is in the set
+    bool Contains(const c8 *strKey, size_t ctChars, u64 iHash) const;
+
+    // Add filename to the set and return true if it wasn't there before
+    bool Add(const c8 *strKey, size_t ctChars);
+
+    inline bool Add(const CString &strKey) {
+      return Add(strKey.c_str(), strKey.length());
+    };
+
+    // Add filename in lowercase without making a lowercase copy of it first
+    bool AddFolded(const c8 *strKey, size_t ctChars);
+
+  private:
+    // Find index of a key and optionally compare it case-insensitively
+    size_t Find(u64 iHash, const c8 *strKey, size_t ctChars, bool bFolded = false) const;
+
+    // Append a new key under some hash
+    void Insert(u64 iHash, const c8 *strKey, size_t ctChars, bool bFold);
+};
+
+#endif
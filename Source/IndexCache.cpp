@@ -0,0 +1,725 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "IndexCache.h"
+#include "GroArchive.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if _DREAMY_UNIX
+  #include <sys/stat.h>
+#else
+  #include <direct.h>
+#endif
+
+CIndexCache _cacheStdDepends;
+CScanCache _cacheScans;
+CCompressionCache _cacheCompression;
+
+// Cache file headers
+static const c8 _aCacheMagic[4] = { 'D', 'G', 'I', 'X' };
+static const u32 _iCacheVersion = 1;
+
+static const c8 _aScanCacheMagic[4] = { 'D', 'G', 'S', 'C' };
+static const u32 _iScanCacheVersion = 2;
+
+static const c8 _aCompressionCacheMagic[4] = { 'D', 'G', 'C', 'C' };
+static const u32 _iCompressionCacheVersion = 1;
+
+// Seconds within which a file can be rewritten without changing its modification time (FAT has the coarsest one)
+static const s64 _iTimeResolution = 2;
+
+// Amount of sampled files of the same type that must agree before the rest isn't sampled anymore
+static const u32 _ctConclusiveSamples = 8;
+
+// Read values from memory with bounds checking
+static bool ReadCacheData(const u8 *&pRead, const u8 *pEnd, void *pData, size_t iSize) {
+  if ((size_t)(pEnd - pRead) < iSize) return false;
+
+  memcpy(pData, pRead, iSize);
+  pRead += iSize;
+  return true;
+};
+
+// Append values to a buffer
+static void WriteCacheData(std::vector<u8> &aData, const void *pData, size_t iSize) {
+  const u8 *pBytes = (const u8 *)pData;
+  aData.insert(aData.end(), pBytes, pBytes + iSize);
+};
+
+// Write cache data into a file, creating its directory if needed
+static void WriteCacheFile(const CString &strFile, const std::vector<u8> &aData) {
+  // Make sure the directory exists
+  const CString strDir = strFile.substr(0, strFile.rfind('/') + 1);
+
+#if _DREAMY_UNIX
+  mkdir(strDir.c_str(), 0755);
+#else
+  _mkdir(strDir.c_str());
+#endif
+
+  // Not being able to write the cache isn't critical
+  FILE *pFile = fopen(strFile.c_str(), "wb");
+  if (pFile == nullptr) return;
+
+  fwrite(&aData[0], 1, aData.size(), pFile);
+  fclose(pFile);
+};
+
+// Load cache from a file once
+void CIndexCache::Load(const CString &strFile) {
+  if (_bLoaded) return;
+
+  _bLoaded = true;
+  _strFile = strFile;
+
+  // No cache yet
+  if (!_file.Open(strFile)) return;
+
+  const u8 *pRead = _file.Data();
+  const u8 *pEnd = pRead + _file.Size();
+
+  c8 aMagic[4];
+  u32 iVersion, ctBlocks;
+
+  if (!ReadCacheData(pRead, pEnd, aMagic, 4) || memcmp(aMagic, _aCacheMagic, 4) != 0
+   || !ReadCacheData(pRead, pEnd, &iVersion, 4) || iVersion != _iCacheVersion
+   || !ReadCacheData(pRead, pEnd, &ctBlocks, 4)) {
+    _file.Close();
+    return;
+  }
+
+  for (u32 iBlock = 0; iBlock < ctBlocks; ++iBlock) {
+    Block_t block;
+    block.ctNames = 0;
+    u32 ctPathChars;
+    u64 iNamesSize;
+
+    bool bRead = ReadCacheData(pRead, pEnd, &ctPathChars, 4) && (size_t)(pEnd - pRead) >= ctPathChars;
+
+    if (bRead) {
+      block.strArchive = CString((const c8 *)pRead, ctPathChars);
+      pRead += ctPathChars;
+
+      bRead = ReadCacheData(pRead, pEnd, &block.info.iSize, 8) && ReadCacheData(pRead, pEnd, &block.info.iTime, 8)
+           && ReadCacheData(pRead, pEnd, &block.ctNames, 4) && ReadCacheData(pRead, pEnd, &iNamesSize, 8)
+           && (u64)(pEnd - pRead) >= iNamesSize;
+    }
+
+    // Discard the entire cache if it's broken
+    if (!bRead) {
+      _aBlocks.clear();
+      _file.Close();
+      return;
+    }
+
+    block.pNames = pRead;
+    block.iNamesSize = (size_t)iNamesSize;
+    block.bUsed = false;
+    pRead += block.iNamesSize;
+
+    _aBlocks.push_back(block);
+  }
+};
+
+// Find block of some archive
+CIndexCache::Block_t *CIndexCache::FindBlock(const CString &strArchive) {
+  for (size_t i = 0; i < _aBlocks.size(); ++i) {
+    if (_aBlocks[i].strArchive == strArchive) return &_aBlocks[i];
+  }
+
+  return nullptr;
+};
+
+// Add cached names of an archive to the set and return false if the archive isn't cached or has changed
+bool CIndexCache::AddNames(const CString &strArchive, const FileInfo_t &info, CDependencySet &aDepends) {
+  Block_t *pBlock = FindBlock(strArchive);
+
+  // Archive has changed since it was cached
+  if (pBlock == nullptr || pBlock->info.iSize != info.iSize || pBlock->info.iTime != info.iTime) {
+    return false;
+  }
+
+  aDepends.Reserve(aDepends.Size() + pBlock->ctNames);
+
+  const u8 *pRead = pBlock->Names();
+  const u8 *pEnd = pRead + pBlock->iNamesSize;
+
+  for (u32 iName = 0; iName < pBlock->ctNames; ++iName) {
+    u16 ctChars;
+
+    if (!ReadCacheData(pRead, pEnd, &ctChars, 2) || (size_t)(pEnd - pRead) < ctChars) {
+      return false;
+    }
+
+    aDepends.Add((const c8 *)pRead, ctChars);
+    pRead += ctChars;
+  }
+
+  pBlock->bUsed = true;
+  return true;
+};
+
+// Remember names that have been read from an archive (encoded using AppendName())
+void CIndexCache::SetNames(const CString &strArchive, const FileInfo_t &info, u32 ctNames, std::vector<u8> &aNames) {
+  Block_t *pBlock = FindBlock(strArchive);
+
+  if (pBlock == nullptr) {
+    _aBlocks.push_back(Block_t());
+    pBlock = &_aBlocks.back();
+    pBlock->strArchive = strArchive;
+  }
+
+  Block_t &block = *pBlock;
+  block.info = info;
+  block.ctNames = ctNames;
+  block.aOwnNames.swap(aNames);
+  block.pNames = nullptr;
+  block.iNamesSize = block.aOwnNames.size();
+  block.bUsed = true;
+
+  _bChanged = true;
+};
+
+// Encode one name in lowercase for SetNames()
+void CIndexCache::AppendName(std::vector<u8> &aNames, const c8 *strName, size_t ctChars) {
+  const u16 ctWrite = (u16)std::min(ctChars, (size_t)0xFFFF);
+  WriteCacheData(aNames, &ctWrite, 2);
+
+  for (size_t i = 0; i < ctWrite; ++i) {
+    aNames.push_back((u8)FoldChar(strName[i]));
+  }
+};
+
+// Save cache into the file if anything has changed
+void CIndexCache::Save(void) {
+  if (!_bChanged || _strFile == "") return;
+
+  _bChanged = false;
+
+  // Gather all blocks in memory before releasing the loaded cache
+  std::vector<u8> aData;
+  WriteCacheData(aData, _aCacheMagic, 4);
+  WriteCacheData(aData, &_iCacheVersion, 4);
+
+  const size_t iBlockCount = aData.size();
+  u32 ctBlocks = 0;
+  WriteCacheData(aData, &ctBlocks, 4);
+
+  for (size_t i = 0; i < _aBlocks.size(); ++i) {
+    const Block_t &block = _aBlocks[i];
+
+    // Forget archives that have been changed or removed since they were cached
+    if (!block.bUsed) {
+      FileInfo_t info;
+
+      if (!GetFileInfo(block.strArchive, info) || info.iSize != block.info.iSize || info.iTime != block.info.iTime) {
+        continue;
+      }
+    }
+
+    const u32 ctPathChars = (u32)block.strArchive.length();
+    const u64 iNamesSize = block.iNamesSize;
+
+    WriteCacheData(aData, &ctPathChars, 4);
+    WriteCacheData(aData, block.strArchive.c_str(), ctPathChars);
+    WriteCacheData(aData, &block.info.iSize, 8);
+    WriteCacheData(aData, &block.info.iTime, 8);
+    WriteCacheData(aData, &block.ctNames, 4);
+    WriteCacheData(aData, &iNamesSize, 8);
+    WriteCacheData(aData, block.Names(), block.iNamesSize);
+
+    ++ctBlocks;
+  }
+
+  memcpy(&aData[iBlockCount], &ctBlocks, 4);
+
+  // Blocks cannot point to the loaded cache anymore
+  _aBlocks.clear();
+  _file.Close();
+
+  WriteCacheFile(_strFile, aData);
+};
+
+// Forget everything without saving it so the cache can be loaded again
+void CIndexCache::Reset(void) {
+  _aBlocks.clear();
+  _file.Close();
+
+  _strFile = "";
+  _bLoaded = false;
+  _bChanged = false;
+};
+
+// Read string with a 32-bit length
+static bool ReadCacheString(const u8 *&pRead, const u8 *pEnd, CString &str) {
+  u32 ctChars;
+  if (!ReadCacheData(pRead, pEnd, &ctChars, 4) || (size_t)(pEnd - pRead) < ctChars) return false;
+
+  str = CString((const c8 *)pRead, ctChars);
+  pRead += ctChars;
+  return true;
+};
+
+// Write string with a 32-bit length
+static void WriteCacheString(std::vector<u8> &aData, const CString &str) {
+  const u32 ctChars = (u32)str.length();
+  WriteCacheData(aData, &ctChars, 4);
+  WriteCacheData(aData, str.c_str(), ctChars);
+};
+
+// Compute CRC32 of an entire file
+static bool HashFile(const CString &strPath, u32 &iHash) {
+  CMappedFile file;
+  if (!file.Open(strPath)) return false;
+
+  iHash = ComputeCRC(0, file.Data(), file.Size());
+  return true;
+};
+
+// Load cache from a file unless it's already loaded from it
+void CScanCache::Load(const CString &strFile) {
+  if (_bLoaded && _strFile == strFile) return;
+
+  // Switch to the cache of another game or mod
+  if (_bLoaded) {
+    Save();
+    Reset();
+  }
+
+  _bLoaded = true;
+  _strFile = strFile;
+
+  // No cache yet
+  CMappedFile file;
+  if (!file.Open(strFile)) return;
+
+  const u8 *pRead = file.Data();
+  const u8 *pEnd = pRead + file.Size();
+
+  c8 aMagic[4];
+  u32 iVersion, ctEntries;
+
+  if (!ReadCacheData(pRead, pEnd, aMagic, 4) || memcmp(aMagic, _aScanCacheMagic, 4) != 0
+   || !ReadCacheData(pRead, pEnd, &iVersion, 4) || iVersion != _iScanCacheVersion
+   || !ReadCacheData(pRead, pEnd, &ctEntries, 4)) {
+    return;
+  }
+
+  for (u32 iEntry = 0; iEntry < ctEntries; ++iEntry) {
+    Entry_t entry;
+    u8 ubSkipped;
+    u32 ctRefs;
+
+    bool bRead = ReadCacheString(pRead, pEnd, entry.strFile) && ReadCacheString(pRead, pEnd, entry.strPath)
+      && ReadCacheData(pRead, pEnd, &entry.info.iSize, 8) && ReadCacheData(pRead, pEnd, &entry.info.iTime, 8)
+      && ReadCacheData(pRead, pEnd, &entry.iHash, 4) && ReadCacheData(pRead, pEnd, &entry.iHashTime, 8)
+      && ReadCacheData(pRead, pEnd, &entry.iFlags, 4)
+      && ReadCacheData(pRead, pEnd, &ubSkipped, 1)
+      && ReadCacheData(pRead, pEnd, &entry.world.iDictPos, 4) && ReadCacheData(pRead, pEnd, &entry.world.iBrushes, 4)
+      && ReadCacheData(pRead, pEnd, &entry.world.iEntities, 4) && ReadCacheData(pRead, pEnd, &entry.world.iFlags, 4)
+      && ReadCacheData(pRead, pEnd, &ctRefs, 4);
+
+    for (u32 iRef = 0; bRead && iRef < ctRefs; ++iRef) {
+      CString strRef;
+      bRead = ReadCacheString(pRead, pEnd, strRef);
+
+      entry.aRefs.push_back(strRef);
+    }
+
+    // Discard the entire cache if it's broken
+    if (!bRead) {
+      _aEntries.clear();
+      _index.Clear();
+      return;
+    }
+
+    entry.bSkipped = (ubSkipped != 0);
+    entry.bUsed = false;
+    AddEntry(entry);
+  }
+};
+
+// Find entry of some file
+size_t CScanCache::FindEntry(const CString &strFile) const {
+  const std::vector<Entry_t> &aEntries = _aEntries;
+
+  return _index.Find(HashFilenameFolded(strFile.c_str(), strFile.length()), [&](size_t iEntry) {
+    const CString &strEntry = aEntries[iEntry].strFile;
+    return strEntry.length() == strFile.length() && EqualFolded(strEntry.c_str(), strFile.c_str(), strFile.length());
+  });
+};
+
+// Add entry to the end and index it
+void CScanCache::AddEntry(const Entry_t &entry) {
+  _aEntries.push_back(entry);
+  _index.Insert(HashFilenameFolded(entry.strFile.c_str(), entry.strFile.length()), _aEntries.size() - 1);
+};
+
+// Retrieve raw scan results of a file and return false if it isn't cached or has changed
+bool CScanCache::Get(const CString &strFile, const CString &strPath, ScanResult_t &result) {
+  FileInfo_t info;
+
+  if (!GetFileInfo(strPath, info)) {
+    ++_ctMisses;
+    return false;
+  }
+
+  FileInfo_t infoCached;
+  u32 iCachedHash;
+  s64 iHashTime;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t iEntry = FindEntry(strFile);
+
+    if (iEntry == NULL_POS || _aEntries[iEntry].info.iSize != info.iSize) {
+      ++_ctMisses;
+      return false;
+    }
+
+    infoCached = _aEntries[iEntry].info;
+    iCachedHash = _aEntries[iEntry].iHash;
+    iHashTime = _aEntries[iEntry].iHashTime;
+  }
+
+  // Trust files that have last been modified long before their contents were hashed, otherwise
+  // make sure the contents are the same because the file might have been rewritten within the
+  // resolution of its modification time
+  const bool bHash = (infoCached.iTime != info.iTime || info.iTime + _iTimeResolution >= iHashTime);
+  const s64 iNow = (s64)time(nullptr);
+
+  if (bHash) {
+    u32 iHash;
+
+    if (!HashFile(strPath, iHash) || iHash != iCachedHash) {
+      ++_ctMisses;
+      return false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  Entry_t &entry = _aEntries[FindEntry(strFile)];
+
+  // Remember new modification time of the same contents
+  if (bHash) {
+    entry.info.iTime = info.iTime;
+    entry.iHashTime = iNow;
+    _bChanged = true;
+
+    ++_ctHashedHits;
+  }
+
+  entry.strPath = strPath;
+  entry.bUsed = true;
+
+  result.iFlags |= entry.iFlags;
+  result.bSkipped = entry.bSkipped;
+  result.world = entry.world;
+  result.aRefs = entry.aRefs;
+
+  ++_ctHits;
+  return true;
+};
+
+// Remember raw scan results of a file
+void CScanCache::Set(const CString &strFile, const CString &strPath, const ScanResult_t &result) {
+  Entry_t entry;
+  entry.strFile = strFile;
+  entry.strPath = strPath;
+
+  // Take the time before reading the file in case it's being rewritten
+  entry.iHashTime = (s64)time(nullptr);
+
+  if (!GetFileInfo(strPath, entry.info) || !HashFile(strPath, entry.iHash)) return;
+
+  entry.iFlags = result.world.iFlags;
+  entry.bSkipped = result.bSkipped;
+  entry.world = result.world;
+  entry.aRefs = result.aRefs;
+  entry.bUsed = true;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const size_t iEntry = FindEntry(strFile);
+
+  if (iEntry != NULL_POS) {
+    _aEntries[iEntry] = entry;
+  } else {
+    AddEntry(entry);
+  }
+
+  _bChanged = true;
+};
+
+// Save cache into the file if anything has changed
+void CScanCache::Save(void) {
+  if (!_bChanged || _strFile == "") return;
+
+  _bChanged = false;
+
+  std::vector<u8> aData;
+  WriteCacheData(aData, _aScanCacheMagic, 4);
+  WriteCacheData(aData, &_iScanCacheVersion, 4);
+
+  const size_t iEntryCount = aData.size();
+  u32 ctEntries = 0;
+  WriteCacheData(aData, &ctEntries, 4);
+
+  for (size_t i = 0; i < _aEntries.size(); ++i) {
+    const Entry_t &entry = _aEntries[i];
+
+    // Forget files that have been changed or removed since they were cached
+    if (!entry.bUsed) {
+      FileInfo_t info;
+
+      if (!GetFileInfo(entry.strPath, info) || info.iSize != entry.info.iSize || info.iTime != entry.info.iTime) {
+        continue;
+      }
+    }
+
+    const u8 ubSkipped = entry.bSkipped;
+    const u32 ctRefs = (u32)entry.aRefs.size();
+
+    WriteCacheString(aData, entry.strFile);
+    WriteCacheString(aData, entry.strPath);
+    WriteCacheData(aData, &entry.info.iSize, 8);
+    WriteCacheData(aData, &entry.info.iTime, 8);
+    WriteCacheData(aData, &entry.iHash, 4);
+    WriteCacheData(aData, &entry.iHashTime, 8);
+    WriteCacheData(aData, &entry.iFlags, 4);
+    WriteCacheData(aData, &ubSkipped, 1);
+    WriteCacheData(aData, &entry.world.iDictPos, 4);
+    WriteCacheData(aData, &entry.world.iBrushes, 4);
+    WriteCacheData(aData, &entry.world.iEntities, 4);
+    WriteCacheData(aData, &entry.world.iFlags, 4);
+    WriteCacheData(aData, &ctRefs, 4);
+
+    for (u32 iRef = 0; iRef < ctRefs; ++iRef) {
+      WriteCacheString(aData, entry.aRefs[iRef]);
+    }
+
+    ++ctEntries;
+  }
+
+  memcpy(&aData[iEntryCount], &ctEntries, 4);
+  WriteCacheFile(_strFile, aData);
+};
+
+// Forget everything without saving it so the cache can be loaded again
+void CScanCache::Reset(void) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  _aEntries.clear();
+  _index.Clear();
+
+  _strFile = "";
+  _bLoaded = false;
+  _bChanged = false;
+};
+
+// Load cache from a file unless it's already loaded from it
+void CCompressionCache::Load(const CString &strFile) {
+  if (_bLoaded && _strFile == strFile) return;
+
+  // Switch to the cache of another game or mod
+  if (_bLoaded) {
+    Save();
+    Reset();
+  }
+
+  _bLoaded = true;
+  _strFile = strFile;
+
+  // No cache yet
+  CMappedFile file;
+  if (!file.Open(strFile)) return;
+
+  const u8 *pRead = file.Data();
+  const u8 *pEnd = pRead + file.Size();
+
+  c8 aMagic[4];
+  u32 iVersion, ctEntries;
+
+  if (!ReadCacheData(pRead, pEnd, aMagic, 4) || memcmp(aMagic, _aCompressionCacheMagic, 4) != 0
+   || !ReadCacheData(pRead, pEnd, &iVersion, 4) || iVersion != _iCompressionCacheVersion
+   || !ReadCacheData(pRead, pEnd, &ctEntries, 4)) {
+    return;
+  }
+
+  for (u32 iEntry = 0; iEntry < ctEntries; ++iEntry) {
+    Entry_t entry;
+    u8 ubStore;
+
+    const bool bRead = ReadCacheString(pRead, pEnd, entry.strFile) && ReadCacheString(pRead, pEnd, entry.strPath)
+      && ReadCacheData(pRead, pEnd, &entry.iSize, 8) && ReadCacheData(pRead, pEnd, &entry.iCRC, 4)
+      && ReadCacheData(pRead, pEnd, &ubStore, 1);
+
+    // Discard the entire cache if it's broken
+    if (!bRead) {
+      _aEntries.clear();
+      _index.Clear();
+      _mapTypes.clear();
+      return;
+    }
+
+    entry.bStore = (ubStore != 0);
+    entry.bUsed = false;
+    AddEntry(entry);
+
+    // Decisions about types are counted from all remembered files
+    Type_t &type = _mapTypes[entry.strFile.GetFileExt().AsLower()];
+    ++(entry.bStore ? type.ctStored : type.ctCompressed);
+  }
+};
+
+// Find entry of some file
+size_t CCompressionCache::FindEntry(const CString &strFile) const {
+  const std::vector<Entry_t> &aEntries = _aEntries;
+
+  return _index.Find(HashFilenameFolded(strFile.c_str(), strFile.length()), [&](size_t iEntry) {
+    const CString &strEntry = aEntries[iEntry].strFile;
+    return strEntry.length() == strFile.length() && EqualFolded(strEntry.c_str(), strFile.c_str(), strFile.length());
+  });
+};
+
+// Add entry to the end and index it
+void CCompressionCache::AddEntry(const Entry_t &entry) {
+  _aEntries.push_back(entry);
+  _index.Insert(HashFilenameFolded(entry.strFile.c_str(), entry.strFile.length()), _aEntries.size() - 1);
+};
+
+// Retrieve decision about a file and return false if it hasn't been sampled or has changed
+bool CCompressionCache::Get(const CString &strFile, u64 iSize, u32 iCRC, bool &bStore) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const size_t iEntry = FindEntry(strFile);
+
+  if (iEntry == NULL_POS) return false;
+
+  Entry_t &entry = _aEntries[iEntry];
+  if (entry.iSize != iSize || entry.iCRC != iCRC) return false;
+
+  entry.bUsed = true;
+  bStore = entry.bStore;
+  return true;
+};
+
+// Remember decision about a sampled file
+void CCompressionCache::Set(const CString &strFile, const CString &strPath, u64 iSize, u32 iCRC, bool bStore) {
+  Entry_t entry;
+  entry.strFile = strFile;
+  entry.strPath = strPath;
+  entry.iSize = iSize;
+  entry.iCRC = iCRC;
+  entry.bStore = bStore;
+  entry.bUsed = true;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  Type_t &type = _mapTypes[strFile.GetFileExt().AsLower()];
+  const size_t iEntry = FindEntry(strFile);
+
+  if (iEntry != NULL_POS) {
+    // Replace the previous decision about the same file
+    --(_aEntries[iEntry].bStore ? type.ctStored : type.ctCompressed);
+    _aEntries[iEntry] = entry;
+
+  } else {
+    AddEntry(entry);
+  }
+
+  ++(bStore ? type.ctStored : type.ctCompressed);
+  _bChanged = true;
+};
+
+// Retrieve decision about all files of some type and return false if its samples aren't conclusive yet
+bool CCompressionCache::GetType(const CString &strExt, bool &bStore) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::map<CString, Type_t>::const_iterator it = _mapTypes.find(strExt);
+
+  if (it == _mapTypes.end()) return false;
+
+  // All samples must agree with each other
+  const Type_t &type = it->second;
+
+  if (type.ctCompressed == 0 && type.ctStored >= _ctConclusiveSamples) {
+    bStore = true;
+    return true;
+
+  } else if (type.ctStored == 0 && type.ctCompressed >= _ctConclusiveSamples) {
+    bStore = false;
+    return true;
+  }
+
+  return false;
+};
+
+// Save cache into the file if anything has changed
+void CCompressionCache::Save(void) {
+  if (!_bChanged || _strFile == "") return;
+
+  _bChanged = false;
+
+  std::vector<u8> aData;
+  WriteCacheData(aData, _aCompressionCacheMagic, 4);
+  WriteCacheData(aData, &_iCompressionCacheVersion, 4);
+
+  const size_t iEntryCount = aData.size();
+  u32 ctEntries = 0;
+  WriteCacheData(aData, &ctEntries, 4);
+
+  for (size_t i = 0; i < _aEntries.size(); ++i) {
+    const Entry_t &entry = _aEntries[i];
+
+    // Forget files that have been changed or removed since they were sampled
+    if (!entry.bUsed) {
+      FileInfo_t info;
+      if (!GetFileInfo(entry.strPath, info) || info.iSize != entry.iSize) continue;
+    }
+
+    const u8 ubStore = entry.bStore;
+
+    WriteCacheString(aData, entry.strFile);
+    WriteCacheString(aData, entry.strPath);
+    WriteCacheData(aData, &entry.iSize, 8);
+    WriteCacheData(aData, &entry.iCRC, 4);
+    WriteCacheData(aData, &ubStore, 1);
+
+    ++ctEntries;
+  }
+
+  memcpy(&aData[iEntryCount], &ctEntries, 4);
+  WriteCacheFile(_strFile, aData);
+};
+
+// Forget everything without saving it so the cache can be loaded again
+void CCompressionCache::Reset(void) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  _aEntries.clear();
+  _index.Clear();
+  _mapTypes.clear();
+
+  _strFile = "";
+  _bLoaded = false;
+  _bChanged = false;
+};
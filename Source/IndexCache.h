@@ -0,0 +1,226 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_INDEXCACHE_H
+#define _DREAMYGRO_INCL_INDEXCACHE_H
+
+#include "Main.h"
+#include "FileSystem.h"
+#include "MappedFile.h"
+#include "DictionaryReader.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+// Cache of entry names from GRO archives that are used as standard dependencies
+class CIndexCache {
+  private:
+    // Names of one archive
+    struct Block_t {
+      CString strArchive; // Full path to the archive
+      FileInfo_t info; // Archive that the names have been read from
+      u32 ctNames;
+
+      const u8 *pNames; // Names as a sequence of 16-bit lengths followed by characters
+      size_t iNamesSize;
+      std::vector<u8> aOwnNames; // Names that haven't been saved in the cache file yet
+
+      bool bUsed; // Has been used during this run
+
+      inline const u8 *Names(void) const {
+        return aOwnNames.empty() ? pNames : &aOwnNames[0];
+      };
+    };
+
+    CString _strFile; // Cache file
+    CMappedFile _file; // Loaded cache
+    std::vector<Block_t> _aBlocks;
+    bool _bLoaded;
+    bool _bChanged;
+
+  public:
+    CIndexCache() : _bLoaded(false), _bChanged(false) {};
+
+    // Load cache from a file once
+    void Load(const CString &strFile);
+
+    // Add cached names of an archive to the set and return false if the archive isn't cached or has changed
+    bool AddNames(const CString &strArchive, const FileInfo_t &info, CDependencySet &aDepends);
+
+    // Remember names that have been read from an archive (encoded using AppendName())
+    void SetNames(const CString &strArchive, const FileInfo_t &info, u32 ctNames, std::vector<u8> &aNames);
+
+    // Encode one name in lowercase for SetNames()
+    static void AppendName(std::vector<u8> &aNames, const c8 *strName, size_t ctChars);
+
+    // Save cache into the file if anything has changed
+    void Save(void);
+
+    // Forget everything without saving it so the cache can be loaded again
+    void Reset(void);
+
+  private:
+    // Find block of some archive
+    Block_t *FindBlock(const CString &strArchive);
+};
+
+extern CIndexCache _cacheStdDepends; // Cache of GRO archives with standard dependencies
+
+// Cache of raw filenames that have been extracted from scanned files
+class CScanCache {
+  private:
+    // Scan results of one file
+    struct Entry_t {
+      CString strFile; // Path relative to the game
+      CString strPath; // Full path to the file
+      FileInfo_t info;
+      u32 iHash; // CRC32 of the entire file
+      s64 iHashTime; // When the contents have been hashed last time
+
+      u32 iFlags;
+      bool bSkipped;
+      WorldDictionaries_t world;
+      Strings_t aRefs;
+
+      bool bUsed; // Has been used during this run
+    };
+
+    CString _strFile; // Cache file
+    std::vector<Entry_t> _aEntries;
+    CHashIndex _index; // Entries by relative paths in lowercase
+    std::mutex _mutex;
+    bool _bLoaded;
+    bool _bChanged;
+
+    std::atomic<u32> _ctHits;
+    std::atomic<u32> _ctHashedHits; // Hits that needed the contents to be hashed
+    std::atomic<u32> _ctMisses;
+
+  public:
+    CScanCache() : _bLoaded(false), _bChanged(false), _ctHits(0), _ctHashedHits(0), _ctMisses(0) {};
+
+    // Start counting cache hits and misses from scratch
+    inline void ResetStats(void) {
+      _ctHits = 0;
+      _ctHashedHits = 0;
+      _ctMisses = 0;
+    };
+
+    inline u32 Hits(void) const {
+      return _ctHits;
+    };
+
+    inline u32 HashedHits(void) const {
+      return _ctHashedHits;
+    };
+
+    inline u32 Misses(void) const {
+      return _ctMisses;
+    };
+
+    // Load cache from a file unless it's already loaded from it (saving the previous one first)
+    void Load(const CString &strFile);
+
+    // Retrieve raw scan results of a file and return false if it isn't cached or its contents have changed
+    bool Get(const CString &strFile, const CString &strPath, ScanResult_t &result);
+
+    // Remember raw scan results of a file
+    void Set(const CString &strFile, const CString &strPath, const ScanResult_t &result);
+
+    // Save cache into the file if anything has changed
+    void Save(void);
+
+    // Forget everything without saving it so the cache can be loaded again
+    void Reset(void);
+
+  private:
+    // Find entry of some file
+    size_t FindEntry(const CString &strFile) const;
+
+    // Add entry to the end and index it
+    void AddEntry(const Entry_t &entry);
+};
+
+extern CScanCache _cacheScans; // Cache of scanned files
+
+// Cache of decisions whether files are worth compressing
+class CCompressionCache {
+  private:
+    // Decision about one file
+    struct Entry_t {
+      CString strFile; // Path relative to the game
+      CString strPath; // Full path to the file
+      u64 iSize;
+      u32 iCRC; // CRC32 of the entire file
+      bool bStore; // Store without compression
+
+      bool bUsed; // Has been used during this run
+    };
+
+    // Decisions about all sampled files of the same type
+    struct Type_t {
+      u32 ctStored;
+      u32 ctCompressed;
+
+      Type_t() : ctStored(0), ctCompressed(0) {};
+    };
+
+    CString _strFile; // Cache file
+    std::vector<Entry_t> _aEntries;
+    CHashIndex _index; // Entries by relative paths in lowercase
+    std::map<CString, Type_t> _mapTypes; // Types by lowercase extensions
+    mutable std::mutex _mutex;
+    bool _bLoaded;
+    bool _bChanged;
+
+  public:
+    CCompressionCache() : _bLoaded(false), _bChanged(false) {};
+
+    // Load cache from a file unless it's already loaded from it (saving the previous one first)
+    void Load(const CString &strFile);
+
+    // Retrieve decision about a file and return false if it hasn't been sampled or has changed
+    bool Get(const CString &strFile, u64 iSize, u32 iCRC, bool &bStore);
+
+    // Remember decision about a sampled file
+    void Set(const CString &strFile, const CString &strPath, u64 iSize, u32 iCRC, bool bStore);
+
+    // Retrieve decision about all files of some type and return false if its samples aren't conclusive yet
+    bool GetType(const CString &strExt, bool &bStore) const;
+
+    // Save cache into the file if anything has changed
+    void Save(void);
+
+    // Forget everything without saving it so the cache can be loaded again
+    void Reset(void);
+
+  private:
+    // Find entry of some file
+    size_t FindEntry(const CString &strFile) const;
+
+    // Add entry to the end and index it
+    void AddEntry(const Entry_t &entry);
+};
+
+extern CCompressionCache _cacheCompression; // Cache of compressibility of packed files
+
+#endif
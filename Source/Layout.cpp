@@ -0,0 +1,110 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Layout.h"
+
+#include <algorithm>
+
+ELayoutOrder _eLayout = LAYOUT_FOUND;
+u32 _iAlignment = 0;
+
+// Files that the engine loads right after the world
+static const c8 *_astrWorldExtras[] = { "Tbn.tex", ".tbn", ".vis" };
+static const size_t _ctWorldExtras = (sizeof(_astrWorldExtras) / sizeof(const c8 *));
+
+// Key for grouping files by their directory and type
+struct LayoutKey_t {
+  CString strDir;
+  CString strExt;
+  size_t iFile;
+};
+
+// Sort keys by directory, then by type
+static bool CompareLayoutKeys(const LayoutKey_t &key1, const LayoutKey_t &key2) {
+  if (key1.strDir != key2.strDir) return key1.strDir < key2.strDir;
+  return key1.strExt < key2.strExt;
+};
+
+// Determine order in which listed files should be written into the archive
+void PlanLayout(const CListedFiles &aFiles, std::vector<size_t> &aOrder) {
+  const size_t ctFiles = aFiles.Size();
+
+  aOrder.clear();
+  aOrder.reserve(ctFiles);
+
+  if (_eLayout == LAYOUT_FOUND) {
+    for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+      aOrder.push_back(iFile);
+    }
+    return;
+  }
+
+  std::vector<bool> abPlaced(ctFiles, false);
+
+  // Worlds go first with files that are loaded together with them
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    const CString strFile = aFiles[iFile].strFile.ToString();
+    if (abPlaced[iFile] || strFile.GetFileExt().AsLower() != ".wld") continue;
+
+    aOrder.push_back(iFile);
+    abPlaced[iFile] = true;
+
+    const CString strNoExt = strFile.RemoveExt();
+
+    for (size_t iExtra = 0; iExtra < _ctWorldExtras; ++iExtra) {
+      const size_t iExtraFile = aFiles.Find(strNoExt + _astrWorldExtras[iExtra]);
+      if (iExtraFile == NULL_POS || abPlaced[iExtraFile]) continue;
+
+      aOrder.push_back(iExtraFile);
+      abPlaced[iExtraFile] = true;
+    }
+  }
+
+  // Keep the rest in the order of discovery, which follows world dictionaries
+  if (_eLayout == LAYOUT_LOAD) {
+    for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+      if (!abPlaced[iFile]) aOrder.push_back(iFile);
+    }
+    return;
+  }
+
+  // Group the rest by directory and type without changing their order within each group
+  std::vector<LayoutKey_t> aKeys;
+
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    if (abPlaced[iFile]) continue;
+
+    const CString strFile = aFiles[iFile].strFile.ToString().AsLower();
+
+    LayoutKey_t key;
+    key.strDir = strFile.substr(0, strFile.find_last_of("/\\") + 1);
+    key.strExt = strFile.GetFileExt();
+    key.iFile = iFile;
+
+    aKeys.push_back(key);
+  }
+
+  std::stable_sort(aKeys.begin(), aKeys.end(), CompareLayoutKeys);
+
+  for (size_t iKey = 0; iKey < aKeys.size(); ++iKey) {
+    aOrder.push_back(aKeys[iKey].iFile);
+  }
+};
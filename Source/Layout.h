@@ -0,0 +1,40 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_LAYOUT_H
+#define _DREAMYGRO_INCL_LAYOUT_H
+
+#include "Main.h"
+
+// Order of entries in the archive
+enum ELayoutOrder {
+  LAYOUT_FOUND, // In the order of discovery
+  LAYOUT_LOAD,  // Worlds with their extra files first and then everything else in the order of discovery
+  LAYOUT_DIR,   // Worlds with their extra files first and then everything else grouped by directory and type
+};
+
+extern ELayoutOrder _eLayout; // Order of entries in the output archive
+extern u32 _iAlignment; // Alignment of data of stored entries in bytes (0 to disable)
+
+// Determine order in which listed files should be written into the archive
+void PlanLayout(const CListedFiles &aFiles, std::vector<size_t> &aOrder);
+
+#endif
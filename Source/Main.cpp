@@ -22,9 +22,16 @@
 #include "Main.h"
 #include "CommandLine.h"
 #include "DictionaryReader.h"
+#include "Packer.h"
+#include "IndexCache.h"
+#include "FileSystem.h"
+#include "GroArchive.h"
+#include "Stats.h"
+#include "Verify.h"
+#include "Watcher.h"
 
-#include <ZipLib/ZipFile.h>
-#include <ZipLib/ZipArchiveEntry.h>
+#include <atomic>
+#include <thread>
 
 // Implement Dreamy Utilities
 #include <DreamyUtilities/DreamyUtilities.cpp>
@@ -33,7 +40,8 @@ CString _strRoot = "";
 CString _strMod = "";
 Strings_t _aScanFiles;
 Strings_t _aNoCompression;
-CHashArray _aStdDepends;
+CDependencySet _aStdDepends;
+CDependencySet _aJobDepends;
 
 CListedFiles _aFilesToPack;
 bool _bCountFiles = false;
@@ -43,56 +51,96 @@ CString _strGRO = "";
 
 u32 _iFlags = 0;
 bool _bPauseAtTheEnd = false;
+CString _strBatch = "";
+CString _strSharedGRO = "";
+size_t _ctSharedMinJobs = 2;
+bool _bWatch = false;
+bool _bVerify = false;
+size_t _ctThreads = 1;
+
+// Get actual amount of threads that can be used
+size_t GetThreadCount(void) {
+  if (_ctThreads != 0) return _ctThreads;
+
+  // Use all cores
+  const size_t ctCores = std::thread::hardware_concurrency();
+  return (ctCores != 0) ? ctCores : 1;
+};
 
 // Check if the file is already in standard dependencies
-bool InDepends(const CString &strFilename, size_t *piHash) {
-  // Get filename hash
-  std::hash<CString> hash;
-  const size_t iHash = hash(strFilename);
+bool InDepends(const CString &strFilename) {
+  return _aStdDepends.Contains(strFilename) || _aJobDepends.Contains(strFilename);
+};
 
-  if (piHash != nullptr) {
-    *piHash = iHash;
-  }
+// Check if the current variant of a key is already in standard dependencies
+bool InDepends(const CPathKey &key) {
+  return _aStdDepends.Contains(key.Data(), key.Length(), key.Hash())
+      || _aJobDepends.Contains(key.Data(), key.Length(), key.Hash());
+};
+
+// Remove all files
+void CListedFiles::Clear(void) {
+  _aFiles.clear();
+  _index.Clear();
+};
 
-  CHashArray::const_iterator it = std::find(_aStdDepends.begin(), _aStdDepends.end(), iHash);
+// Find index of the file regardless of the case
+size_t CListedFiles::Find(const CString &strFilename) const {
+  const c8 *strFind = strFilename.c_str();
+  const size_t ctChars = strFilename.length();
 
-  // Already in there
-  return (it != _aStdDepends.end());
+  return Find(strFind, ctChars, HashFilenameFolded(strFind, ctChars));
 };
 
-// Check if the file is already added
-bool InFiles(CString strFilename) {
-  strFilename.ToLower();
+// Find index of the file with an already computed HashFilenameFolded()
+size_t CListedFiles::Find(const c8 *strFilename, size_t ctChars, u64 iFoldedHash) const {
+  const std::vector<ListedFile_t> &aFiles = _aFiles;
 
-  CListedFiles::const_iterator it;
+  return _index.Find(iFoldedHash, [&](size_t iFile) {
+    const CName &strListed = aFiles[iFile].strFile;
+    return strListed.length() == ctChars && EqualFolded(strListed.c_str(), strFilename, ctChars);
+  });
+};
 
-  // Case insensitive search
-  for (it = _aFilesToPack.begin(); it != _aFilesToPack.end(); ++it) {
-    CString strInFiles = it->strFile.AsLower();
+// Add file to the end of the list without checking for duplicates
+void CListedFiles::Add(const ListedFile_t &file) {
+  Add(file, HashFilenameFolded(file.strFile.c_str(), file.strFile.length()));
+};
 
-    if (strInFiles == strFilename) {
-      return true;
-    }
-  }
+// Add file with an already computed HashFilenameFolded()
+void CListedFiles::Add(const ListedFile_t &file, u64 iFoldedHash) {
+  _aFiles.push_back(file);
+  _index.Insert(iFoldedHash, _aFiles.size() - 1);
+};
 
-  return false;
+// Check if the file is already added
+bool InFiles(const CString &strFilename) {
+  return _aFilesToPack.Find(strFilename) != NULL_POS;
 };
 
 // Add new file to the list and return true if it wasn't there before
 bool AddFile(const CString &strFilename) {
-  if (InFiles(strFilename)) {
+  return AddFile(strFilename.c_str(), strFilename.length(), HashFilenameFolded(strFilename.c_str(), strFilename.length()));
+};
+
+// Add new file with an already computed HashFilenameFolded() without copying it if it's already there
+bool AddFile(const c8 *strFilename, size_t ctChars, u64 iFoldedHash) {
+  if (_aFilesToPack.Find(strFilename, ctChars, iFoldedHash) != NULL_POS) {
     return false;
   }
 
+  // Share the same copy with other users of the filename
+  const CName strFile = _arenaNames.Intern(strFilename, ctChars);
+
   if (_bCountFiles) {
     // Count one dependency
     ++_ctFiles;
-    std::cout << _ctFiles << ". " << strFilename << '\n';
+    std::cout << _ctFiles << ". " << strFile << '\n';
 
-    _aFilesToPack.push_back(ListedFile_t(strFilename, _ctFiles));
+    _aFilesToPack.Add(ListedFile_t(strFile, _ctFiles), iFoldedHash);
 
   } else {
-    _aFilesToPack.push_back(ListedFile_t(strFilename, 0));
+    _aFilesToPack.Add(ListedFile_t(strFile, 0), iFoldedHash);
   }
 
   return true;
@@ -100,21 +148,8 @@ bool AddFile(const CString &strFilename) {
 
 // Replace MP directories with normal ones
 void ReplaceRevDirs(CString &strFilename) {
-  CString strCheck = strFilename.AsLower();
-  s32 ctChars = 0;
-
   // Remove 'MP' from some directories
-  if (strCheck.StartsWith("modelsmp") || strCheck.StartsWith("soundsmp")) {
-    ctChars = 6;
-  } else if (strCheck.StartsWith("musicmp")) {
-    ctChars = 5;
-  } else if (strCheck.StartsWith("datamp")) {
-    ctChars = 4;
-  } else if (strCheck.StartsWith("texturesmp")) {
-    ctChars = 8;
-  } else if (strCheck.StartsWith("animationsmp")) {
-    ctChars = 10;
-  }
+  const size_t ctChars = FindRevDirSuffix(strFilename.c_str(), strFilename.length());
 
   if (ctChars == 0) return;
   strFilename.erase(ctChars, 2);
@@ -135,33 +170,52 @@ void VerifyWorldFile(CDataStream &strmWorld) {
   }
 };
 
-// Check if some listed dependency exists
-// Return values: 0 - doesn't exist; 1 - exists under root; 2 - exists under mod
-static s32 CheckFile(CString strFile) {
+// Check if some listed dependency exists and optionally retrieve a full path to it
+// Return values: 0 - doesn't exist; 1 - exists under root; 2 - exists under mod; 3 - exists in a source archive
+s32 CheckFile(CString strFile, CString *pstrFullPath) {
+  const bool bStats = CollectStats();
+  CStopwatch sw;
+
+  const CString strListed = strFile;
+  CString strFullPath;
+  s32 iResult = 0;
+
   // Dependency exists in the mod directory
-  if (_strMod != "" && FileExists(_strRoot + _strMod + strFile)) return 2;
+  if (_strMod != "" && FindFile(_strRoot + _strMod + strFile, &strFullPath)) {
+    iResult = 2;
 
   // Dependency exists in the root directory
-  if (FileExists(_strRoot + strFile)) return 1;
+  } else if (FindFile(_strRoot + strFile, &strFullPath)) {
+    iResult = 1;
 
   // Try again for SSR directories
-  if (IsRev()) {
+  } else if (IsRev()) {
     ReplaceRevDirs(strFile);
-    if (FileExists(_strRoot + strFile)) return 1;
+    if (FindFile(_strRoot + strFile, &strFullPath)) iResult = 1;
   }
 
-  return 0;
+  // Dependency can be copied from one of the source archives
+  if (iResult == 0 && _groSources.Find(strListed, nullptr, &strFullPath) != nullptr) {
+    iResult = 3;
+  }
+
+  if (iResult != 0 && pstrFullPath != nullptr) {
+    *pstrFullPath = strFullPath;
+  }
+
+  if (bStats) AddCheckTime(sw.Seconds());
+  return iResult;
 };
 
 // Display a list of files that cannot be used
 static bool DisplayFailedFiles(const CListedFiles &aFailed, const CString &strError) {
-  if (aFailed.empty()) {
+  if (aFailed.IsEmpty()) {
     return false;
   }
 
   std::cout << strError << '\n';
 
-  for (size_t i = 0; i < aFailed.size(); ++i) {
+  for (size_t i = 0; i < aFailed.Size(); ++i) {
     const ListedFile_t &file = aFailed[i];
     std::cout << file.iNumber << ". " << file.strFile << '\n';
   }
@@ -170,6 +224,243 @@ static bool DisplayFailedFiles(const CListedFiles &aFailed, const CString &strEr
   return true;
 };
 
+// File that needs to be scanned for dependencies
+struct ScanFile_t {
+  CString strFile; // Relative path
+  CString strPath; // Full path
+
+  ScanFile_t(const CString &strSetFile, const CString &strSetPath) :
+    strFile(strSetFile), strPath(strSetPath) {};
+};
+
+// Collect dependencies of one file and remember the error instead of throwing it
+static void CollectSafely(const ScanFile_t &file, ScanResult_t &result) {
+  CStopwatch sw;
+
+  try {
+    CollectDependencies(file.strFile, file.strPath, result);
+
+  } catch (CMessageException &ex) {
+    result.strFile = file.strFile;
+    result.strError = ex.what();
+
+  } catch (std::exception &ex) {
+    result.strFile = file.strFile;
+    result.strError = ex.what();
+  }
+
+  result.dSeconds = sw.Seconds();
+};
+
+// Collect dependencies from multiple files at the same time
+static void CollectInParallel(const std::vector<ScanFile_t> &aFiles, std::vector<ScanResult_t> &aResults) {
+  const size_t ctFiles = aFiles.size();
+  const size_t ctThreads = std::min(GetThreadCount(), ctFiles);
+
+  aResults.clear();
+  aResults.resize(ctFiles);
+
+  if (ctThreads <= 1) {
+    for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+      CollectSafely(aFiles[iFile], aResults[iFile]);
+    }
+    return;
+  }
+
+  std::atomic<size_t> iNextFile(0);
+  std::vector<std::thread> aThreads;
+
+  for (size_t iThread = 0; iThread < ctThreads; ++iThread) {
+    aThreads.push_back(std::thread([&]() {
+      for (;;) {
+        const size_t iFile = iNextFile++;
+        if (iFile >= ctFiles) break;
+
+        CollectSafely(aFiles[iFile], aResults[iFile]);
+      }
+    }));
+  }
+
+  for (size_t iThread = 0; iThread < ctThreads; ++iThread) {
+    aThreads[iThread].join();
+  }
+};
+
+// Scan included files for dependencies
+void ScanIncludedFiles(void) {
+  // Start counting dependencies
+  _bCountFiles = true;
+  _ctFiles = 0;
+
+  const size_t ctScanFiles = _aScanFiles.size();
+
+  // No files to scan
+  if (ctScanFiles == 0) {
+    throw CMessageException("No files to scan for dependencies");
+  }
+
+  // Files that have already been scanned
+  CDependencySet aScanned;
+  std::vector<ScanFile_t> aWave;
+
+  for (size_t iScanFile = 0; iScanFile < ctScanFiles; ++iScanFile) {
+    const CString &strFile = _aScanFiles[iScanFile];
+
+    aWave.push_back(ScanFile_t(strFile, _strRoot + _strMod + strFile));
+    aScanned.Add(strFile.AsLower());
+  }
+
+  std::vector<ScanResult_t> aResults;
+
+  // Reuse filenames from files that haven't changed since the last run
+  _cacheScans.Load(_strRoot + _strMod + "Temp/DreamyGRO_ScanCache.bin");
+  _cacheScans.ResetStats();
+
+  // The first wave only has included files
+  bool bFoundFiles = false;
+
+  // Scan each wave of newly found files at the same time
+  while (!aWave.empty()) {
+    CollectInParallel(aWave, aResults);
+
+    // Add dependencies in the same order the files have been found in
+    const size_t iFirstNew = _aFilesToPack.Size();
+
+    for (size_t iResult = 0; iResult < aResults.size(); ++iResult) {
+      const ScanResult_t &result = aResults[iResult];
+
+      // Only hide found files without dependencies, not included ones
+      if (result.bSkipped && bFoundFiles) continue;
+
+      std::cout << "\nExtra dependencies for '" << result.strFile << "':\n";
+
+      if (result.strError != "") {
+        throw CMessageException(result.strError);
+      }
+
+      CStopwatch sw;
+      MergeDependencies(result);
+
+      if (CollectStats()) {
+        AddPhaseTime("Scan " + result.strFile, result.dSeconds);
+        AddPhaseTime("Merge " + result.strFile, sw.Seconds());
+      }
+    }
+
+    aWave.clear();
+    if (!Recursive()) break;
+
+    bFoundFiles = true;
+
+    // Queue new files that haven't been scanned yet
+    for (size_t iFile = iFirstNew; iFile < _aFilesToPack.Size(); ++iFile) {
+      const CString strFile = _aFilesToPack[iFile].strFile.ToString();
+      if (!CanHaveDependencies(strFile) || !aScanned.Add(strFile.AsLower())) continue;
+
+      // Skip files that aren't on disk (including ones from source archives)
+      CString strPath;
+      const s32 iCheck = CheckFile(strFile, &strPath);
+      if (iCheck != 1 && iCheck != 2) continue;
+
+      aWave.push_back(ScanFile_t(strFile, strPath));
+    }
+  }
+
+  _cacheScans.Save();
+
+  std::cout << "\nScan cache: " << _cacheScans.Hits() << " hits (" << _cacheScans.HashedHits() << " checked by contents), "
+    << _cacheScans.Misses() << " misses\n";
+};
+
+// Pack found dependencies into a GRO or only check their existence
+bool ProcessDependencies(void) {
+  // Files that couldn't be packed
+  CListedFiles aFailed;
+
+  const size_t ctFiles = _aFilesToPack.Size();
+
+  // Compare the existing archive instead of packing a new one
+  if (_bVerify) {
+    return VerifyArchive(_aFilesToPack);
+
+  // No dependencies to pack
+  } else if (ctFiles == 0) {
+    std::cout << "\nAll files are already in standard dependencies! Nothing else needs to be packed :)\n";
+
+  // Pack all the dependencies
+  } else if (!OnlyDep()) {
+    std::cout << "\nPacking files...\n";
+
+    try {
+      CPhaseTimer timer("Packing");
+      PackFiles(_aFilesToPack, aFailed);
+
+    } catch (std::runtime_error &err) {
+      std::cout << "Error: " << err.what() << " (" << strerror(errno) << ")\n";
+      return false;
+    }
+
+    // Display files that couldn't be packed
+    DisplayFailedFiles(aFailed, "\nCouldn't pack these files:");
+    std::cout << '"' << _strGRO << "\" is ready!\n";
+
+  // Only show dependencies
+  } else {
+    std::cout << "\nChecking for physical existence of files...\n";
+
+    // Go through file dependencies
+    for (size_t iFile = 0; iFile < _aFilesToPack.Size(); ++iFile) {
+      const ListedFile_t &listed = _aFilesToPack[iFile];
+      const s32 iCheck = CheckFile(listed.strFile.ToString());
+
+      // Skip if no file
+      if (iCheck == 0) {
+        aFailed.Add(listed);
+        continue;
+      }
+    }
+
+    // Display files that don't exist
+    if (!DisplayFailedFiles(aFailed, "\nFiles that aren't on disk:")) {
+      // No failed files
+      std::cout << "\nAll files exist!\n";
+    }
+  }
+
+  return true;
+};
+
+// Remember state of the packer that's specific to each job
+void SavePackerState(PackerState_t &state) {
+  state.aScanFiles = _aScanFiles;
+  state.aNoCompression = _aNoCompression;
+  state.eCompression = _eCompression;
+  state.aCompressionRules = _aCompressionRules;
+  state.aJobDepends = _aJobDepends;
+  state.aFilesToPack = _aFilesToPack;
+  state.bCountFiles = _bCountFiles;
+  state.ctFiles = _ctFiles;
+  state.strGRO = _strGRO;
+  state.iFlags = _iFlags;
+};
+
+// Restore state of the packer that's specific to each job
+void RestorePackerState(const PackerState_t &state) {
+  _aScanFiles = state.aScanFiles;
+  _aNoCompression = state.aNoCompression;
+  _eCompression = state.eCompression;
+  _aCompressionRules = state.aCompressionRules;
+  _aJobDepends = state.aJobDepends;
+  _aFilesToPack = state.aFilesToPack;
+  _bCountFiles = state.bCountFiles;
+  _ctFiles = state.ctFiles;
+  _strGRO = state.strGRO;
+  _iFlags = state.iFlags;
+};
+
+// The benchmark provides its own entry point
+#ifndef DREAMYGRO_BENCHMARK
+
 // Pause command line execution
 static void Pause(void) {
   if (_bPauseAtTheEnd) {
@@ -179,6 +470,278 @@ static void Pause(void) {
   }
 };
 
+// Display a list of dependencies with new numbers
+static void DisplayListedFiles(const CListedFiles &aFiles) {
+  for (size_t i = 0; i < aFiles.Size(); ++i) {
+    std::cout << (i + 1) << ". " << aFiles[i].strFile << '\n';
+  }
+
+  if (aFiles.IsEmpty()) {
+    std::cout << "No dependencies\n";
+  }
+};
+
+// Scan all jobs first, pack files that are used by multiple jobs into the common GRO and then pack each job without them
+static bool RunSharedBatch(const std::vector<Strings_t> &aJobs, const PackerState_t &stateCommon) {
+  const size_t ctJobs = aJobs.size();
+
+  std::vector<PackerState_t> aJobStates(ctJobs);
+  std::vector<bool> abScanned(ctJobs, false);
+  size_t ctFailedJobs = 0;
+
+  // Every file from all jobs in the order of discovery and amounts of jobs that use them
+  CListedFiles aAllFiles;
+  std::vector<size_t> actFileJobs;
+
+  for (size_t iJob = 0; iJob < ctJobs; ++iJob) {
+    RestorePackerState(stateCommon);
+
+    std::cout << "\n=== Scanning job " << (iJob + 1) << '/' << ctJobs << " ===\n";
+
+    try {
+      ParseJobArguments(aJobs[iJob]);
+      ScanIncludedFiles();
+
+    } catch (CMessageException &ex) {
+      std::cout << "Error: " << ex.what() << '\n';
+      ++ctFailedJobs;
+      continue;
+    }
+
+    // Standard dependencies of the job are only needed for scanning
+    _aJobDepends.Clear();
+
+    SavePackerState(aJobStates[iJob]);
+    abScanned[iJob] = true;
+
+    for (size_t iFile = 0; iFile < _aFilesToPack.Size(); ++iFile) {
+      const ListedFile_t &file = _aFilesToPack[iFile];
+      const size_t iFound = aAllFiles.Find(file.strFile.ToString());
+
+      if (iFound != NULL_POS) {
+        ++actFileJobs[iFound];
+      } else {
+        aAllFiles.Add(file);
+        actFileJobs.push_back(1);
+      }
+    }
+  }
+
+  // Files that are used by enough jobs
+  CListedFiles aShared;
+
+  for (size_t iFile = 0; iFile < aAllFiles.Size(); ++iFile) {
+    if (actFileJobs[iFile] >= _ctSharedMinJobs) {
+      aShared.Add(ListedFile_t(aAllFiles[iFile].strFile, aShared.Size() + 1));
+    }
+  }
+
+  RestorePackerState(stateCommon);
+
+  std::cout << "\n=== Common GRO ===\n";
+  std::cout << "\nDependencies that are used by at least " << _ctSharedMinJobs << " jobs:\n";
+  DisplayListedFiles(aShared);
+
+  // Pack shared files once
+  bool bShared = true;
+
+  if (!aShared.IsEmpty()) {
+    _strGRO = _strSharedGRO;
+    _aFilesToPack = aShared;
+
+    bShared = ProcessDependencies();
+  }
+
+  for (size_t iJob = 0; iJob < ctJobs; ++iJob) {
+    if (!abScanned[iJob]) continue;
+
+    RestorePackerState(aJobStates[iJob]);
+
+    std::cout << "\n=== Job " << (iJob + 1) << '/' << ctJobs << " ===\n";
+
+    // Only keep files that are unique to this job
+    CListedFiles aUnique;
+
+    for (size_t iFile = 0; iFile < _aFilesToPack.Size(); ++iFile) {
+      const ListedFile_t &file = _aFilesToPack[iFile];
+      if (aShared.Find(file.strFile.ToString()) != NULL_POS) continue;
+
+      aUnique.Add(ListedFile_t(file.strFile, aUnique.Size() + 1));
+    }
+
+    std::cout << "\nUnique dependencies (" << (_aFilesToPack.Size() - aUnique.Size()) << " are in the common GRO):\n";
+    DisplayListedFiles(aUnique);
+
+    _aFilesToPack = aUnique;
+
+    if (!ProcessDependencies()) ++ctFailedJobs;
+  }
+
+  RestorePackerState(stateCommon);
+
+  if (!bShared) {
+    std::cout << "\nCouldn't pack the common GRO!\n";
+  }
+
+  std::cout << "\nFinished " << (ctJobs - ctFailedJobs) << '/' << ctJobs << " jobs successfully\n";
+  return (ctFailedJobs == 0 && bShared);
+};
+
+// Run all jobs from the batch manifest and return false if any of them have failed
+static bool RunBatch(void) {
+  std::vector<Strings_t> aJobs;
+  ReadBatchManifest(_strBatch, aJobs);
+
+  const size_t ctJobs = aJobs.size();
+
+  if (ctJobs == 0) {
+    throw CMessageException("No jobs in the batch manifest!");
+  }
+
+  // Every job starts from the state after parsing common arguments
+  PackerState_t stateCommon;
+  SavePackerState(stateCommon);
+
+  if (_strSharedGRO != "") {
+    return RunSharedBatch(aJobs, stateCommon);
+  }
+
+  size_t ctFailedJobs = 0;
+
+  for (size_t iJob = 0; iJob < ctJobs; ++iJob) {
+    RestorePackerState(stateCommon);
+
+    std::cout << "\n=== Job " << (iJob + 1) << '/' << ctJobs << " ===\n";
+
+    try {
+      ParseJobArguments(aJobs[iJob]);
+      ScanIncludedFiles();
+
+      if (!ProcessDependencies()) {
+        ++ctFailedJobs;
+      }
+
+    } catch (CMessageException &ex) {
+      std::cout << "Error: " << ex.what() << '\n';
+      ++ctFailedJobs;
+    }
+  }
+
+  RestorePackerState(stateCommon);
+
+  std::cout << "\nFinished " << (ctJobs - ctFailedJobs) << '/' << ctJobs << " jobs successfully\n";
+  return (ctFailedJobs == 0);
+};
+
+// Time without any changes before repacking in watch mode
+static const u32 _iWatchDelayMs = 500;
+
+// Collect files that the GRO depends on, including ones that can appear later
+static void CollectWatchedFiles(Strings_t &aFiles) {
+  CString strPath;
+
+  for (size_t i = 0; i < _aScanFiles.size(); ++i) {
+    const CString &strFile = _aScanFiles[i];
+    aFiles.push_back(FindFile(_strRoot + _strMod + strFile, &strPath) ? strPath : _strRoot + _strMod + strFile);
+
+    // Extra files of a world
+    if (strFile.GetFileExt().AsLower() == ".wld") {
+      const CString strNoExt = _strRoot + _strMod + strFile.RemoveExt();
+
+      aFiles.push_back(strNoExt + "Tbn.tex");
+      aFiles.push_back(strNoExt + ".tbn");
+      aFiles.push_back(strNoExt + ".vis");
+    }
+  }
+
+  for (size_t i = 0; i < _aFilesToPack.Size(); ++i) {
+    const CString strFile = _aFilesToPack[i].strFile.ToString();
+    const s32 iCheck = CheckFile(strFile, &strPath);
+
+    if (iCheck == 1 || iCheck == 2) {
+      aFiles.push_back(strPath);
+      continue;
+    }
+
+    // Files that don't exist on disk yet
+    aFiles.push_back(_strRoot + _strMod + strFile);
+    if (_strMod != "") aFiles.push_back(_strRoot + strFile);
+  }
+};
+
+// Repack the GRO from the state before scanning whenever any of its files change
+static bool RunWatch(PackerState_t &stateBeforeScan) {
+  CFileWatcher watcher;
+
+  // Included files that haven't been created yet
+  const Strings_t &aIncludedPatterns = GetIncludedPatterns();
+  Strings_t aPatterns;
+
+  for (size_t i = 0; i < aIncludedPatterns.size(); ++i) {
+    aPatterns.push_back(_strRoot + _strMod + aIncludedPatterns[i]);
+  }
+
+  for (;;) {
+    Strings_t aFiles;
+    CollectWatchedFiles(aFiles);
+
+    if (!watcher.Watch(_strRoot, aFiles, aPatterns)) {
+      std::cout << "Error: Cannot watch files for changes!\n";
+      return false;
+    }
+
+    std::cout << "\nWatching " << aFiles.size() << " files for changes (press Ctrl+C to stop)...\n";
+
+    Strings_t aChanged;
+    bool bCreatedOrRemoved;
+
+    if (!watcher.Wait(_iWatchDelayMs, aChanged, bCreatedOrRemoved)) {
+      std::cout << "Error: Cannot wait for changes of files!\n";
+      return false;
+    }
+
+    std::cout << "\nChanged files:\n";
+
+    for (size_t i = 0; i < aChanged.size(); ++i) {
+      std::cout << (i + 1) << ". " << aChanged[i] << '\n';
+    }
+
+    // Measure each rebuild separately
+    ResetStats();
+
+    // Rescan files from scratch while reusing results of unchanged files and entries in the existing GRO
+    RestorePackerState(stateBeforeScan);
+
+    try {
+      // Files have appeared or disappeared since they've been indexed
+      if (bCreatedOrRemoved) {
+        {
+          CPhaseTimer timer("Index files");
+          _fileIndex.Build(_strRoot, _strMod, GetThreadCount());
+        }
+
+        // Include files that match patterns from scratch and use them in the next rebuilds as well
+        RefreshIncludedPatterns();
+        SavePackerState(stateBeforeScan);
+      }
+
+      _iFlags |= SCAN_INC;
+
+      {
+        CPhaseTimer timer("Scanning");
+        ScanIncludedFiles();
+      }
+
+      ProcessDependencies();
+
+    } catch (CMessageException &ex) {
+      std::cout << "Error: " << ex.what() << '\n';
+    }
+
+    ReportStats();
+  }
+};
+
 // Entry point
 int main(int ctArgs, char *astrArgs[]) {
   std::cout << "Dreamy GRO - (c) Dreamy Cecil, 2022-2024\n";
@@ -198,6 +761,9 @@ int main(int ctArgs, char *astrArgs[]) {
   }
   std::cout << "\n";
 
+  // State of the packer for repacking in watch mode
+  PackerState_t stateBeforeScan;
+
   try {
     // Parse command line arguments
     bool bParsed = ParseArguments(aArgs);
@@ -230,7 +796,7 @@ int main(int ctArgs, char *astrArgs[]) {
         CString strRelative = FromFullFilePath(strFile, "Levels");
         AddFile(strRelative); // The world itself should be packed too
 
-      } else if (strCheckExt == ".dll") {
+      } else if (strCheckExt == ".dll" || strCheckExt == ".so") {
         FromFullFilePath(strFile, "Bin");
 
       } else {
@@ -238,32 +804,25 @@ int main(int ctArgs, char *astrArgs[]) {
       }
     }
 
-    std::cout << "Standard dependencies: " << _aStdDepends.size() << '\n';
+    // Keep names of standard dependencies for the next run
+    _cacheStdDepends.Save();
 
-    // Start counting dependencies
-    _bCountFiles = true;
-    _ctFiles = 0;
+    std::cout << "Standard dependencies: " << _aStdDepends.Size() << '\n';
 
-    const size_t ctScanFiles = _aScanFiles.size();
+    // Pack multiple GROs using the same standard dependencies
+    if (_strBatch != "") {
+      const bool bSuccess = RunBatch();
+      ReportStats();
 
-    // No files to scan
-    if (ctScanFiles == 0) {
-      throw CMessageException("No files to scan for dependencies");
+      Pause();
+      return bSuccess ? 0 : 1;
     }
 
-    for (size_t iScanFile = 0; iScanFile < ctScanFiles; ++iScanFile) {
-      CString strFile = _aScanFiles[iScanFile];
-
-      std::cout << "\nExtra dependencies for '" << strFile << "':\n";
-
-      const CString strCheckExt = strFile.GetFileExt().AsLower();
+    // Remember state before scanning for repacking it later
+    if (_bWatch) SavePackerState(stateBeforeScan);
 
-      if (strCheckExt == ".wld") {
-        ScanWorld(strFile);
-      } else {
-        ScanAnyFile(strFile, strCheckExt == ".dll");
-      }
-    }
+    CPhaseTimer timer("Scanning");
+    ScanIncludedFiles();
 
   } catch (bool bExit) {
     // Terminate application execution
@@ -276,108 +835,16 @@ int main(int ctArgs, char *astrArgs[]) {
     return 1;
   }
 
-  // Files that couldn't be packed
-  CListedFiles aFailed;
-
-  const size_t ctFiles = _aFilesToPack.size();
-
-  // No dependencies to pack
-  if (ctFiles == 0) {
-    std::cout << "\nAll files are already in standard dependencies! Nothing else needs to be packed :)\n";
-
-  // Pack all the dependencies
-  } else if (!OnlyDep()) {
-    std::cout << "\nPacking files...\n";
-
-    try {
-      // Create a new GRO file
-      std::remove(_strGRO.c_str());
-      ZipArchive::Ptr pGro = ZipFile::Open(_strGRO);
-
-      // Go through file dependencies
-      for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
-        const ListedFile_t &listed = _aFilesToPack[iFile];
-        CString strFile = listed.strFile;
-
-        const s32 iCheck = CheckFile(strFile);
-
-        // Skip if no file
-        if (iCheck == 0) {
-          aFailed.push_back(listed);
-          continue;
-        }
-
-        // Add file under the relative directory
-        ZipArchiveEntry::Ptr pEntry = pGro->CreateEntry(strFile);
-
-        // Skip if can't create an entry
-        if (pEntry == nullptr) {
-          aFailed.push_back(listed);
-          continue;
-        }
-
-        // Write real file
-        std::ifstream file;
+  bool bSuccess = ProcessDependencies();
+  ReportStats();
 
-        if (iCheck == 2) {
-          file.open(_strRoot + _strMod + strFile, std::ios::binary);
-        } else {
-          file.open(_strRoot + strFile, std::ios::binary);
-        }
-
-        // Determine compression method
-        ICompressionMethod::Ptr pMethod;
-
-        // Find extension in the list
-        const CString strExt = strFile.GetFileExt().AsLower();
-        Strings_t::const_iterator itStore = std::find(_aNoCompression.begin(), _aNoCompression.end(), strExt);
-
-        // Store files of this type
-        if (itStore != _aNoCompression.end()) {
-          pMethod = StoreMethod::Create();
-        } else {
-          pMethod = DeflateMethod::Create();
-        }
-
-        pEntry->SetCompressionStream(file, pMethod, ZipArchiveEntry::CompressionMode::Immediate);
-      }
-
-      ZipFile::SaveAndClose(pGro, _strGRO);
-
-    } catch (std::runtime_error &err) {
-      std::cout << "Error: " << err.what() << " (" << strerror(errno) << ")\n";
-
-      Pause();
-      return 1;
-    }
-
-    // Display files that couldn't be packed
-    DisplayFailedFiles(aFailed, "\nCouldn't pack these files:");
-    std::cout << '"' << _strGRO << "\" is ready!\n";
-
-  // Only show dependencies
-  } else {
-    std::cout << "\nChecking for physical existence of files...\n";
-
-    // Go through file dependencies
-    for (size_t iFile = 0; iFile < _aFilesToPack.size(); ++iFile) {
-      const ListedFile_t &listed = _aFilesToPack[iFile];
-      const s32 iCheck = CheckFile(listed.strFile);
-
-      // Skip if no file
-      if (iCheck == 0) {
-        aFailed.push_back(listed);
-        continue;
-      }
-    }
-
-    // Display files that don't exist
-    if (!DisplayFailedFiles(aFailed, "\nFiles that aren't on disk:")) {
-      // No failed files
-      std::cout << "\nAll files exist!\n";
-    }
+  // Keep packing the same files until the process is terminated
+  if (_bWatch) {
+    bSuccess = RunWatch(stateBeforeScan);
   }
 
   Pause();
-  return 0;
+  return bSuccess ? 0 : 1;
 };
+
+#endif
@@ -35,23 +35,61 @@ using namespace dreamy;
 #include <fstream>
 #include <vector>
 
-typedef std::vector<size_t> CHashArray;
+#include "Compression.h"
+#include "Hashing.h"
+#include "PathKey.h"
+#include "StringArena.h"
 
 struct ListedFile_t {
-  CString strFile;
+  CName strFile; // Stored in the arena with names of all dependencies
   size_t iNumber;
 
-  ListedFile_t(const CString &strSet, size_t iSet) : strFile(strSet), iNumber(iSet) {};
+  ListedFile_t(const CName &strSet, size_t iSet) : strFile(strSet), iNumber(iSet) {};
 };
 
-typedef std::vector<ListedFile_t> CListedFiles;
+// List of files in the order of addition with a case insensitive index
+class CListedFiles {
+  private:
+    std::vector<ListedFile_t> _aFiles;
+    CHashIndex _index;
+
+  public:
+    // Remove all files
+    void Clear(void);
+
+    // Amount of files in the list
+    inline size_t Size(void) const {
+      return _aFiles.size();
+    };
+
+    inline bool IsEmpty(void) const {
+      return _aFiles.empty();
+    };
+
+    inline const ListedFile_t &operator[](size_t i) const {
+      return _aFiles[i];
+    };
+
+    // Find index of the file regardless of the case
+    size_t Find(const CString &strFilename) const;
+
+    // Find index of the file with an already computed HashFilenameFolded()
+    size_t Find(const c8 *strFilename, size_t ctChars, u64 iFoldedHash) const;
+
+    // Add file to the end of the list without checking for duplicates
+    void Add(const ListedFile_t &file);
+
+    // Add file with an already computed HashFilenameFolded()
+    void Add(const ListedFile_t &file, u64 iFoldedHash);
+};
 
 // Preparation
 extern CString _strRoot;          // Game folder directory
 extern CString _strMod;           // Extra mod folder relative to the game directory (if packing from there)
 extern Strings_t _aScanFiles;     // List of files to scan for dependencies
 extern Strings_t _aNoCompression; // List of files for packing without compression
-extern CHashArray _aStdDepends;   // List of standard dependencies
+extern CDependencySet _aStdDepends; // List of standard dependencies
+extern CDependencySet _aJobDepends; // Standard dependencies that have been added by the current batch job
 
 extern CListedFiles _aFilesToPack; // Final list of files to pack
 extern bool _bCountFiles; // Start counting extra dependencies using the counter below
@@ -66,10 +104,22 @@ enum EPackerFlags {
   SCAN_DEP = (1 << 3), // Only show list of dependencies without packing
   SCAN_GRO = (1 << 4), // Automatically detect GRO files from certain games
   SCAN_MOD = (1 << 5), // Erase mod directory from paths to dependencies
+  SCAN_INC = (1 << 6), // Update an existing GRO by reusing entries of unchanged files
+  SCAN_REC = (1 << 7), // Scan found dependencies for their own dependencies
+  SCAN_AUTO = (1 << 8), // Store files that barely compress according to a sample of their data
 };
 
 extern u32 _iFlags; // Packer behavior flags
 extern bool _bPauseAtTheEnd; // Pause program execution before closing it
+extern size_t _ctThreads; // Amount of threads for packing files (0 for all available cores)
+extern CString _strBatch; // Manifest with multiple packing jobs
+extern CString _strSharedGRO; // Common GRO for files that are used by multiple jobs in a batch
+extern size_t _ctSharedMinJobs; // Amount of jobs that must use a file for it to go into the common GRO
+extern bool _bWatch; // Keep running and repack the GRO whenever any of its files change
+extern bool _bVerify; // Compare an existing GRO with its files instead of packing it
+
+// Get actual amount of threads that can be used
+size_t GetThreadCount(void);
 
 inline bool IsRev(void)     { return (_iFlags & SCAN_SSR) != 0; };
 inline bool PackINI(void)   { return (_iFlags & SCAN_INI) != 0; };
@@ -77,20 +127,59 @@ inline bool PackOGG(void)   { return (_iFlags & SCAN_OGG) != 0; };
 inline bool OnlyDep(void)   { return (_iFlags & SCAN_DEP) != 0; };
 inline bool DetectGRO(void) { return (_iFlags & SCAN_GRO) != 0; };
 inline bool EraseMod(void)  { return (_iFlags & SCAN_MOD) != 0; };
+inline bool Incremental(void) { return (_iFlags & SCAN_INC) != 0; };
+inline bool Recursive(void) { return (_iFlags & SCAN_REC) != 0; };
+inline bool Adaptive(void)  { return (_iFlags & SCAN_AUTO) != 0; };
+
+// State of the packer that's specific to each packing job (standard dependencies are shared between all of them)
+struct PackerState_t {
+  Strings_t aScanFiles;
+  Strings_t aNoCompression;
+  ECompressionLevel eCompression;
+  CCompressionRules aCompressionRules;
+  CDependencySet aJobDepends;
+  CListedFiles aFilesToPack;
+  bool bCountFiles;
+  size_t ctFiles;
+  CString strGRO;
+  u32 iFlags;
+};
+
+// Remember state of the packer that's specific to each job
+void SavePackerState(PackerState_t &state);
+
+// Restore state of the packer that's specific to each job
+void RestorePackerState(const PackerState_t &state);
 
 // Check if the file is already in standard dependencies
-bool InDepends(const CString &strFilename, size_t *piHash = nullptr);
+bool InDepends(const CString &strFilename);
+
+// Check if the current variant of a key is already in standard dependencies
+bool InDepends(const CPathKey &key);
 
 // Check if the file is already added
-bool InFiles(CString strFilename);
+bool InFiles(const CString &strFilename);
 
 // Add new file to the list and return true if it wasn't there before
 bool AddFile(const CString &strFilename);
 
+// Add new file with an already computed HashFilenameFolded() without copying it if it's already there
+bool AddFile(const c8 *strFilename, size_t ctChars, u64 iFoldedHash);
+
 // Replace MP directories with normal ones
 void ReplaceRevDirs(CString &strFilename);
 
 // Check if it's a valid world file
 void VerifyWorldFile(CDataStream &strmWorld);
 
+// Scan included files for dependencies
+void ScanIncludedFiles(void);
+
+// Pack found dependencies into a GRO or only check their existence
+bool ProcessDependencies(void);
+
+// Check if some listed dependency exists and optionally retrieve a full path to it
+// Return values: 0 - doesn't exist; 1 - exists under root; 2 - exists under mod; 3 - exists in a source archive
+s32 CheckFile(CString strFile, CString *pstrFullPath = nullptr);
+
 #endif
@@ -0,0 +1,170 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MappedFile.h"
+
+#if _DREAMY_UNIX
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#endif
+
+CMappedFile::CMappedFile() : _pData(nullptr), _iSize(0)
+{
+#if _DREAMY_UNIX
+  _iFile = -1;
+#else
+  _hFile = INVALID_HANDLE_VALUE;
+  _hMapping = NULL;
+#endif
+};
+
+CMappedFile::~CMappedFile() {
+  Close();
+};
+
+// Map the file into memory or read it into a buffer if it cannot be mapped
+bool CMappedFile::Open(const CString &strFile) {
+  Close();
+
+#if _DREAMY_UNIX
+  int iFile = open(strFile.c_str(), O_RDONLY);
+  if (iFile == -1) return false;
+
+  struct stat st;
+
+  if (fstat(iFile, &st) != 0) {
+    close(iFile);
+    return false;
+  }
+
+  _iSize = (size_t)st.st_size;
+
+  // Nothing to map
+  if (_iSize == 0) {
+    close(iFile);
+    return true;
+  }
+
+  void *pMapped = mmap(nullptr, _iSize, PROT_READ, MAP_PRIVATE, iFile, 0);
+
+  if (pMapped != MAP_FAILED) {
+    // Files are always read from start to end
+    madvise(pMapped, _iSize, MADV_SEQUENTIAL);
+
+    _iFile = iFile;
+    _pData = (const u8 *)pMapped;
+    return true;
+  }
+
+  close(iFile);
+
+#else
+  HANDLE hFile = CreateFileA(strFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (hFile == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER liSize;
+
+  if (!GetFileSizeEx(hFile, &liSize)) {
+    CloseHandle(hFile);
+    return false;
+  }
+
+  _iSize = (size_t)liSize.QuadPart;
+
+  // Nothing to map
+  if (_iSize == 0) {
+    CloseHandle(hFile);
+    return true;
+  }
+
+  HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if (hMapping != NULL) {
+    void *pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (pView != NULL) {
+      _hFile = hFile;
+      _hMapping = hMapping;
+      _pData = (const u8 *)pView;
+      return true;
+    }
+
+    CloseHandle(hMapping);
+  }
+
+  CloseHandle(hFile);
+#endif
+
+  // Couldn't map the file
+  return ReadIntoBuffer(strFile);
+};
+
+// Read the entire file into the buffer
+bool CMappedFile::ReadIntoBuffer(const CString &strFile) {
+  std::ifstream file(strFile.c_str(), std::ios::binary);
+
+  if (!file.is_open()) {
+    _iSize = 0;
+    return false;
+  }
+
+  _aBuffer.resize(_iSize);
+  file.read((char *)&_aBuffer[0], _iSize);
+  _aBuffer.resize((size_t)file.gcount());
+
+  _iSize = _aBuffer.size();
+  _pData = (_iSize != 0) ? &_aBuffer[0] : nullptr;
+
+  return true;
+};
+
+// Release file contents
+void CMappedFile::Close(void) {
+#if _DREAMY_UNIX
+  if (_pData != nullptr && _aBuffer.empty()) {
+    munmap((void *)_pData, _iSize);
+  }
+
+  if (_iFile != -1) {
+    close(_iFile);
+    _iFile = -1;
+  }
+
+#else
+  if (_hMapping != NULL) {
+    UnmapViewOfFile(_pData);
+    CloseHandle(_hMapping);
+    CloseHandle(_hFile);
+
+    _hFile = INVALID_HANDLE_VALUE;
+    _hMapping = NULL;
+  }
+#endif
+
+  _aBuffer.clear();
+  _pData = nullptr;
+  _iSize = 0;
+};
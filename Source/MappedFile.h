@@ -0,0 +1,76 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_MAPPEDFILE_H
+#define _DREAMYGRO_INCL_MAPPEDFILE_H
+
+#include "Main.h"
+
+// Read-only view of an entire file in memory
+class CMappedFile {
+  private:
+    const u8 *_pData;
+    size_t _iSize;
+
+    std::vector<u8> _aBuffer; // File contents if it couldn't be mapped
+
+  #if _DREAMY_UNIX
+    int _iFile; // Descriptor of the mapped file for copying it without reading
+  #else
+    void *_hFile;
+    void *_hMapping;
+  #endif
+
+  public:
+    CMappedFile();
+    ~CMappedFile();
+
+    // Map the file into memory or read it into a buffer if it cannot be mapped
+    bool Open(const CString &strFile);
+
+    // Release file contents
+    void Close(void);
+
+    inline const u8 *Data(void) const {
+      return _pData;
+    };
+
+    inline size_t Size(void) const {
+      return _iSize;
+    };
+
+  #if _DREAMY_UNIX
+    // Descriptor of the mapped file or -1 if the file is in the buffer
+    inline int Descriptor(void) const {
+      return _iFile;
+    };
+  #endif
+
+  private:
+    // Read the entire file into the buffer
+    bool ReadIntoBuffer(const CString &strFile);
+
+    // Disallow copying
+    CMappedFile(const CMappedFile &);
+    CMappedFile &operator=(const CMappedFile &);
+};
+
+#endif
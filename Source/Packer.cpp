@@ -0,0 +1,462 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Packer.h"
+#include "Compression.h"
+#include "GroArchive.h"
+#include "FileSystem.h"
+#include "IndexCache.h"
+#include "Layout.h"
+#include "MappedFile.h"
+#include "Stats.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// One file that's being packed
+struct PackJob_t {
+  const ListedFile_t *pListed;
+  CString strSource; // Full path to the file on disk
+  bool bStore; // Store without compression
+  ECompressionLevel eLevel; // Compression level if it's not stored
+  bool bSample; // Decide whether to store it from a sample of its data
+  bool bAutoStored; // Has been stored because it barely compresses
+
+  // Results
+  bool bFailed;
+  bool bDone;
+  CString strError;
+
+  GroEntry_t entry;
+  std::vector<u8> aCompressed; // Deflated data
+  std::shared_ptr<CMappedFile> pStored; // Mapped file for storing as is
+
+  // Incremental update
+  const GroEntry_t *pOldEntry; // Same entry in the previous archive
+  const u8 *pReused; // Compressed data of the old entry if the file hasn't changed
+
+  // Entry in a source archive that's copied as is
+  const GroEntry_t *pSourceEntry;
+  const u8 *pSourceData;
+
+  double dSeconds; // Time spent preparing the entry
+
+  PackJob_t() : pListed(nullptr), bStore(false), eLevel(COMPRESSION_DEFAULT), bSample(false), bAutoStored(false), bFailed(false), bDone(false),
+    pOldEntry(nullptr), pReused(nullptr), pSourceEntry(nullptr), pSourceData(nullptr), dSeconds(0.0) {};
+};
+
+// Check if files of some type should be stored without compression
+static bool StoreFileType(const CString &strFile) {
+  const CString strExt = strFile.GetFileExt().AsLower();
+  Strings_t::const_iterator itStore = std::find(_aNoCompression.begin(), _aNoCompression.end(), strExt);
+
+  return (itStore != _aNoCompression.end());
+};
+
+// Amount of bytes from the beginning of a file that are compressed to see if it's worth it
+static const size_t _iSampleSize = 64 * 1024;
+
+// Minimal fraction of bytes that compression must save in order to be worth it
+static const double _dMinGain = 0.05;
+
+// Check if a sample from the beginning of the data compresses well enough
+static bool WorthCompressing(const u8 *pData, size_t iSize) {
+  const size_t iSample = std::min(iSize, _iSampleSize);
+  if (iSample == 0) return false;
+
+  // Fastest level is enough for an estimate
+  std::vector<u8> aSample;
+  DeflateData(pData, iSample, aSample, COMPRESSION_FAST);
+
+  return aSample.size() <= iSample * (1.0 - _dMinGain);
+};
+
+// Read the file and compress its data, if needed
+static void PrepareJob(PackJob_t &job) {
+  GroEntry_t &entry = job.entry;
+
+  // Copy already compressed data from the source archive
+  if (job.pSourceEntry != nullptr) {
+    const GroEntry_t &source = *job.pSourceEntry;
+
+    entry.strName = job.pListed->strFile.ToString();
+    entry.iMethod = source.iMethod;
+    entry.iFlags = (source.iFlags & 6); // Only keep bits of the compression level
+    entry.iTime = source.iTime;
+    entry.iDate = source.iDate;
+    entry.iCRC = source.iCRC;
+    entry.iPackedSize = source.iPackedSize;
+    entry.iSize = source.iSize;
+    return;
+  }
+
+  FileInfo_t info;
+
+  std::shared_ptr<CMappedFile> pFile(new CMappedFile);
+
+  if (!GetFileInfo(job.strSource, info) || !pFile->Open(job.strSource)) {
+    job.bFailed = true;
+    return;
+  }
+
+  // Serious Engine cannot read ZIP64 archives
+  if (pFile->Size() > 0xFFFFFFFF) {
+    job.bFailed = true;
+    return;
+  }
+
+  entry.strName = job.pListed->strFile.ToString();
+  entry.iSize = (u32)pFile->Size();
+  entry.iCRC = ComputeCRC(0, pFile->Data(), pFile->Size());
+  ToDosTime(info.iTime, entry.iTime, entry.iDate);
+
+  // Reuse the decision from the last time the same data has been sampled
+  if (job.bSample && !_cacheCompression.Get(entry.strName, entry.iSize, entry.iCRC, job.bStore)) {
+    job.bStore = !WorthCompressing(pFile->Data(), pFile->Size());
+    _cacheCompression.Set(entry.strName, job.strSource, entry.iSize, entry.iCRC, job.bStore);
+  }
+
+  if (job.bSample) job.bAutoStored = job.bStore;
+  entry.iMethod = (job.bStore ? GROMETHOD_STORE : GROMETHOD_DEFLATE);
+  entry.iFlags = (job.bStore ? 0 : GetDeflateFlags(job.eLevel));
+
+  // Reuse already compressed data if the file hasn't changed since the last time
+  if (job.pReused != nullptr) {
+    const GroEntry_t &old = *job.pOldEntry;
+
+    if (old.iSize == entry.iSize && old.iTime == entry.iTime && old.iDate == entry.iDate
+     && old.iCRC == entry.iCRC && old.iMethod == entry.iMethod && old.iFlags == entry.iFlags) {
+      entry.iPackedSize = old.iPackedSize;
+      return;
+    }
+
+    // Compress it again
+    job.pReused = nullptr;
+  }
+
+  // Keep the file mapped until it's written
+  if (job.bStore) {
+    entry.iPackedSize = entry.iSize;
+    job.pStored = pFile;
+    return;
+  }
+
+  DeflateData(pFile->Data(), pFile->Size(), job.aCompressed, job.eLevel);
+
+  // Store the file after all if the rest of it didn't compress as well as the sample
+  if (job.bSample && job.aCompressed.size() >= pFile->Size()) {
+    std::vector<u8>().swap(job.aCompressed);
+    _cacheCompression.Set(entry.strName, job.strSource, entry.iSize, entry.iCRC, true);
+
+    job.bStore = true;
+    job.bAutoStored = true;
+    entry.iMethod = GROMETHOD_STORE;
+    entry.iFlags = 0;
+    entry.iPackedSize = entry.iSize;
+    job.pStored = pFile;
+    return;
+  }
+
+  entry.iPackedSize = (u32)job.aCompressed.size();
+};
+
+// Prepare the job without letting any errors escape from the thread
+static void PrepareJobSafely(PackJob_t &job) {
+  // Nothing to prepare
+  if (job.bFailed) return;
+
+  CStopwatch sw;
+
+  try {
+    PrepareJob(job);
+
+  } catch (std::exception &ex) {
+    job.strError = ex.what();
+  }
+
+  job.dSeconds = sw.Seconds();
+};
+
+// Write the prepared job into the archive and release its data
+static void WriteJob(CGroWriter &gro, PackJob_t &job) {
+  if (job.strError != "") {
+    throw std::runtime_error(job.strError.c_str());
+  }
+
+  if (!job.bFailed) {
+    if (job.pSourceData != nullptr) {
+      gro.AddEntry(job.entry, job.pSourceData);
+
+    } else if (job.pReused != nullptr) {
+      gro.AddEntry(job.entry, job.pReused);
+
+    } else if (job.bStore) {
+      gro.AddStoredEntry(job.entry, *job.pStored);
+    } else {
+      gro.AddEntry(job.entry, job.aCompressed.empty() ? nullptr : &job.aCompressed[0]);
+    }
+  }
+
+  if (!job.bFailed && CollectStats()) {
+    AddEntryStats(job.entry.strName, job.entry.iSize, job.entry.iPackedSize, job.dSeconds);
+  }
+
+  job.pStored.reset();
+  std::vector<u8>().swap(job.aCompressed);
+};
+
+// Prepare jobs on multiple threads and write them in their original order
+static void PackInParallel(CGroWriter &gro, std::vector<PackJob_t> &aJobs, size_t ctThreads) {
+  const size_t ctJobs = aJobs.size();
+
+  // Limit how many prepared files can wait in memory for the writer
+  const size_t ctMaxPending = ctThreads * 2;
+
+  std::mutex mx;
+  std::condition_variable cvPrepared;
+  std::condition_variable cvWritten;
+
+  size_t iNextJob = 0;
+  size_t ctWritten = 0;
+  bool bAbort = false;
+
+  std::vector<std::thread> aThreads;
+
+  for (size_t iThread = 0; iThread < ctThreads; ++iThread) {
+    aThreads.push_back(std::thread([&]() {
+      for (;;) {
+        size_t iJob;
+
+        {
+          std::unique_lock<std::mutex> lock(mx);
+
+          // Wait until there's space for another prepared file
+          cvWritten.wait(lock, [&]() {
+            return bAbort || iNextJob >= ctJobs || iNextJob < ctWritten + ctMaxPending;
+          });
+
+          if (bAbort || iNextJob >= ctJobs) return;
+          iJob = iNextJob++;
+        }
+
+        PrepareJobSafely(aJobs[iJob]);
+
+        {
+          std::lock_guard<std::mutex> lock(mx);
+          aJobs[iJob].bDone = true;
+        }
+
+        cvPrepared.notify_all();
+      }
+    }));
+  }
+
+  try {
+    // Write files in order as soon as they are ready
+    for (size_t iJob = 0; iJob < ctJobs; ++iJob) {
+      PackJob_t &job = aJobs[iJob];
+
+      {
+        std::unique_lock<std::mutex> lock(mx);
+        cvPrepared.wait(lock, [&]() { return job.bDone; });
+      }
+
+      WriteJob(gro, job);
+
+      {
+        std::lock_guard<std::mutex> lock(mx);
+        ctWritten = iJob + 1;
+      }
+
+      cvWritten.notify_all();
+    }
+
+  } catch (...) {
+    // Stop all threads before leaving
+    {
+      std::lock_guard<std::mutex> lock(mx);
+      bAbort = true;
+    }
+
+    cvWritten.notify_all();
+
+    for (size_t iThread = 0; iThread < aThreads.size(); ++iThread) {
+      aThreads[iThread].join();
+    }
+
+    throw;
+  }
+
+  for (size_t iThread = 0; iThread < aThreads.size(); ++iThread) {
+    aThreads[iThread].join();
+  }
+};
+
+// Pack listed files into the output GRO archive and collect files that couldn't be packed
+void PackFiles(const CListedFiles &aFiles, CListedFiles &aFailed) {
+  const size_t ctFiles = aFiles.Size();
+  std::vector<PackJob_t> aJobs(ctFiles);
+
+  // Write files in the order that the engine is going to load them in
+  std::vector<size_t> aOrder;
+  PlanLayout(aFiles, aOrder);
+
+  // Open the previous archive to reuse its entries
+  CGroReader groOld;
+  const bool bUpdate = (Incremental() && groOld.Open(_strGRO));
+
+  // Remember which files are worth compressing between runs
+  if (Adaptive()) {
+    _cacheCompression.Load(_strRoot + _strMod + "Temp/DreamyGRO_CompressionCache.bin");
+  }
+
+  // Go through file dependencies
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    PackJob_t &job = aJobs[iFile];
+    job.pListed = &aFiles[aOrder[iFile]];
+
+    const CString strFile = job.pListed->strFile.ToString();
+    const s32 iCheck = CheckFile(strFile, &job.strSource);
+
+    // Skip if no file
+    if (iCheck == 0) {
+      job.bFailed = true;
+      job.bDone = true;
+      continue;
+    }
+
+    // Copy compressed entry from the source archive
+    if (iCheck == 3) {
+      job.pSourceEntry = _groSources.Find(strFile, &job.pSourceData);
+      continue;
+    }
+
+    // Determine compression method
+    job.bStore = StoreFileType(strFile);
+    job.eLevel = GetCompressionLevel(strFile);
+
+    // Sample files unless all sampled files of the same type have been compressed the same way
+    if (!job.bStore && Adaptive()) {
+      if (_cacheCompression.GetType(strFile.GetFileExt().AsLower(), job.bStore)) {
+        job.bAutoStored = job.bStore;
+      } else {
+        job.bSample = true;
+      }
+    }
+
+    // Find the same entry in the previous archive
+    if (bUpdate) {
+      const size_t iOld = groOld.Find(strFile);
+      if (iOld == NULL_POS) continue;
+
+      const GroEntry_t &old = groOld[iOld];
+
+      // Skip encrypted entries and entries with different names
+      if ((old.iFlags & 1) || old.strName != strFile) continue;
+
+      job.pOldEntry = &old;
+      job.pReused = groOld.GetData(old);
+    }
+  }
+
+  // Write a new GRO file next to the previous one
+  const CString strTempGRO = _strGRO + ".tmp";
+
+  CGroWriter gro;
+  gro.Create(strTempGRO);
+  gro.SetAlignment(_iAlignment);
+
+  const size_t ctThreads = std::min(GetThreadCount(), ctFiles);
+
+  try {
+    if (ctThreads > 1) {
+      PackInParallel(gro, aJobs, ctThreads);
+
+    } else {
+      for (size_t iJob = 0; iJob < ctFiles; ++iJob) {
+        PackJob_t &job = aJobs[iJob];
+
+        PrepareJobSafely(job);
+        WriteJob(gro, job);
+      }
+    }
+
+    gro.Finish();
+
+  } catch (...) {
+    // Don't leave an unfinished archive behind
+    gro.Discard();
+    throw;
+  }
+
+  groOld.Close();
+
+  _cacheCompression.Save();
+
+  // Replace the previous archive
+  std::remove(_strGRO.c_str());
+
+  if (std::rename(strTempGRO.c_str(), _strGRO.c_str()) != 0) {
+    throw std::runtime_error("Cannot replace the archive");
+  }
+
+  size_t ctPacked = 0;
+  size_t ctReused = 0;
+  size_t ctCopied = 0;
+  size_t ctAutoStored = 0;
+
+  // Jobs of listed files
+  std::vector<size_t> aJobOfFile(ctFiles);
+
+  for (size_t iJob = 0; iJob < ctFiles; ++iJob) {
+    aJobOfFile[aOrder[iJob]] = iJob;
+  }
+
+  // Collect files that couldn't be packed in their original order
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    const PackJob_t &job = aJobs[aJobOfFile[iFile]];
+
+    if (job.bFailed) {
+      aFailed.Add(*job.pListed);
+      continue;
+    }
+
+    ++ctPacked;
+    if (job.pReused != nullptr) ++ctReused;
+    if (job.pSourceData != nullptr) ++ctCopied;
+    if (job.bAutoStored) ++ctAutoStored;
+  }
+
+  if (Adaptive()) {
+    std::cout << "Stored incompressible files: " << ctAutoStored << '/' << ctPacked << '\n';
+  }
+
+  if (ctCopied != 0) {
+    std::cout << "Copied from source archives: " << ctCopied << '/' << ctPacked << '\n';
+  }
+
+  if (bUpdate) {
+    std::cout << "Reused unchanged files: " << ctReused << '/' << ctPacked << '\n';
+  }
+};
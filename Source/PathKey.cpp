@@ -0,0 +1,107 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PathKey.h"
+
+#include <string.h>
+
+// SSR directories that have the same contents as regular ones without 'MP' at the end
+static const c8 *_astrRevDirs[] = {
+  "modelsmp", "soundsmp", "musicmp", "datamp", "texturesmp", "animationsmp",
+};
+
+static const size_t _ctRevDirs = (sizeof(_astrRevDirs) / sizeof(_astrRevDirs[0]));
+
+// Position of 'MP' in an SSR directory at the beginning of a path in any case (0 if there's none)
+size_t FindRevDirSuffix(const c8 *strPath, size_t ctChars) {
+  for (size_t i = 0; i < _ctRevDirs; ++i) {
+    const size_t ctDir = strlen(_astrRevDirs[i]);
+
+    if (ctChars >= ctDir && EqualFolded(strPath, _astrRevDirs[i], ctDir)) return ctDir - 2;
+  }
+
+  return 0;
+};
+
+// Set key from a filename in any case
+void CPathKey::Set(const c8 *strFilename, size_t ctChars) {
+  // Reuse already allocated characters
+  _strKey.assign(strFilename, ctChars);
+
+  for (size_t i = 0; i < ctChars; ++i) {
+    _strKey[i] = FoldChar(_strKey[i]);
+  }
+
+  Rehash();
+};
+
+// Check if the key starts with a lowercase prefix
+bool CPathKey::StartsWith(const CString &strPrefix) const {
+  return _strKey.compare(0, strPrefix.length(), strPrefix) == 0;
+};
+
+// Check if the key ends with a lowercase extension
+bool CPathKey::HasExt(const c8 *strExt) const {
+  const size_t ctExt = strlen(strExt);
+  const size_t ctKey = _strKey.length();
+
+  return ctKey >= ctExt && _strKey.compare(ctKey - ctExt, ctExt, strExt) == 0;
+};
+
+// Erase some amount of characters from the beginning
+void CPathKey::EraseStart(size_t ctChars) {
+  _strKey.erase(0, ctChars);
+  Rehash();
+};
+
+// Replace MP3 extension with OGG and return false if it's not an MP3 file
+bool CPathKey::ReplaceMP3WithOGG(void) {
+  if (!HasExt(".mp3")) return false;
+
+  _strKey.replace(_strKey.length() - 3, 3, "ogg");
+  Rehash();
+  return true;
+};
+
+// Remove 'MP' from SSR directories and return false if there were none
+bool CPathKey::ReplaceRevDirs(void) {
+  const size_t ctChars = FindRevDirSuffix(_strKey.c_str(), _strKey.length());
+  if (ctChars == 0) return false;
+
+  _strKey.erase(ctChars, 2);
+  Rehash();
+  return true;
+};
+
+// Replace spaces with underscores and return false if there were none
+bool CPathKey::ReplaceSpaces(void) {
+  bool bReplaced = false;
+
+  for (size_t i = 0; i < _strKey.length(); ++i) {
+    if (_strKey[i] != ' ') continue;
+
+    _strKey[i] = '_';
+    bReplaced = true;
+  }
+
+  if (bReplaced) Rehash();
+  return bReplaced;
+};
@@ -0,0 +1,89 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_PATHKEY_H
+#define _DREAMYGRO_INCL_PATHKEY_H
+
+#include "Hashing.h"
+
+// Position of 'MP' in an SSR directory at the beginning of a path in any case (0 if there's none)
+size_t FindRevDirSuffix(const c8 *strPath, size_t ctChars);
+
+// Lowercase key of a dependency that's modified in place into different variants of the same filename
+// The buffer is reused between filenames and the hash is only computed when the key changes
+class CPathKey {
+  private:
+    CString _strKey; // Current variant in lowercase
+    u64 _iHash; // Hash of the current variant
+
+  public:
+    CPathKey() : _iHash(0) {};
+
+    // Set key from a filename in any case
+    void Set(const c8 *strFilename, size_t ctChars);
+
+    inline void Set(const CString &strFilename) {
+      Set(strFilename.c_str(), strFilename.length());
+    };
+
+    inline const CString &Key(void) const {
+      return _strKey;
+    };
+
+    inline const c8 *Data(void) const {
+      return _strKey.c_str();
+    };
+
+    inline size_t Length(void) const {
+      return _strKey.length();
+    };
+
+    // Same as HashFilename() of the key and HashFilenameFolded() of the original filename
+    inline u64 Hash(void) const {
+      return _iHash;
+    };
+
+    // Check if the key starts with a lowercase prefix
+    bool StartsWith(const CString &strPrefix) const;
+
+    // Check if the key ends with a lowercase extension
+    bool HasExt(const c8 *strExt) const;
+
+    // Erase some amount of characters from the beginning
+    void EraseStart(size_t ctChars);
+
+    // Replace MP3 extension with OGG and return false if it's not an MP3 file
+    bool ReplaceMP3WithOGG(void);
+
+    // Remove 'MP' from SSR directories and return false if there were none
+    bool ReplaceRevDirs(void);
+
+    // Replace spaces with underscores and return false if there were none
+    bool ReplaceSpaces(void);
+
+  private:
+    // Hash the current key
+    inline void Rehash(void) {
+      _iHash = HashFilename(_strKey.c_str(), _strKey.length());
+    };
+};
+
+#endif
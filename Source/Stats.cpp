@@ -0,0 +1,258 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Stats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+bool _bStats = false;
+CString _strStatsJSON = "";
+
+// Amount of slowest entries to display
+static const size_t _ctSlowestEntries = 10;
+
+// Time of some phase
+struct PhaseStats_t {
+  CString strPhase;
+  double dSeconds;
+};
+
+// One packed entry
+struct EntryStats_t {
+  CString strFile;
+  u64 iSizeIn;
+  u64 iSizeOut;
+  double dSeconds;
+};
+
+// Packed entries of the same type
+struct ExtStats_t {
+  size_t ctEntries;
+  u64 iSizeIn;
+  u64 iSizeOut;
+  double dSeconds;
+
+  ExtStats_t() : ctEntries(0), iSizeIn(0), iSizeOut(0), dSeconds(0.0) {};
+};
+
+static std::vector<PhaseStats_t> _aPhases;
+static std::vector<EntryStats_t> _aEntries;
+
+static size_t _ctChecks = 0;
+static double _dCheckSeconds = 0.0;
+
+CPhaseTimer::CPhaseTimer(const CString &strPhase) : _strPhase(strPhase), _bActive(CollectStats())
+{
+};
+
+CPhaseTimer::~CPhaseTimer() {
+  if (_bActive) AddPhaseTime(_strPhase, _sw.Seconds());
+};
+
+// Record time of some phase
+void AddPhaseTime(const CString &strPhase, double dSeconds) {
+  PhaseStats_t phase;
+  phase.strPhase = strPhase;
+  phase.dSeconds = dSeconds;
+
+  _aPhases.push_back(phase);
+};
+
+// Record time of one existence check
+void AddCheckTime(double dSeconds) {
+  ++_ctChecks;
+  _dCheckSeconds += dSeconds;
+};
+
+// Record one packed entry
+void AddEntryStats(const CString &strFile, u64 iSizeIn, u64 iSizeOut, double dSeconds) {
+  EntryStats_t entry;
+  entry.strFile = strFile;
+  entry.iSizeIn = iSizeIn;
+  entry.iSizeOut = iSizeOut;
+  entry.dSeconds = dSeconds;
+
+  _aEntries.push_back(entry);
+};
+
+// Megabytes per second
+static double Throughput(u64 iBytes, double dSeconds) {
+  return (dSeconds > 0.0) ? (iBytes / 1048576.0 / dSeconds) : 0.0;
+};
+
+// Compressed size relative to uncompressed size
+static double Ratio(u64 iSizeIn, u64 iSizeOut) {
+  return (iSizeIn != 0) ? ((double)iSizeOut / (double)iSizeIn) : 1.0;
+};
+
+// Write string with escaped characters for JSON
+static void WriteJSONString(std::ostream &strm, const CString &str) {
+  strm << '"';
+
+  for (size_t i = 0; i < str.length(); ++i) {
+    const c8 ch = str[i];
+
+    if (ch == '"' || ch == '\\') {
+      strm << '\\' << ch;
+
+    } else if ((u8)ch < 0x20) {
+      strm << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (u32)(u8)ch << std::dec << std::setfill(' ');
+
+    } else {
+      strm << ch;
+    }
+  }
+
+  strm << '"';
+};
+
+// Sort entries from the slowest
+static bool CompareEntryTime(const EntryStats_t *pEntry1, const EntryStats_t *pEntry2) {
+  return pEntry1->dSeconds > pEntry2->dSeconds;
+};
+
+// Display collected timings and write them into a JSON file, if needed
+void ReportStats(void) {
+  if (!CollectStats()) return;
+
+  // Gather entries by type
+  std::map<CString, ExtStats_t> mapExts;
+  ExtStats_t total;
+
+  std::vector<const EntryStats_t *> aSlowest;
+
+  for (size_t i = 0; i < _aEntries.size(); ++i) {
+    const EntryStats_t &entry = _aEntries[i];
+    ExtStats_t &ext = mapExts[entry.strFile.GetFileExt().AsLower()];
+
+    ++ext.ctEntries;
+    ext.iSizeIn += entry.iSizeIn;
+    ext.iSizeOut += entry.iSizeOut;
+    ext.dSeconds += entry.dSeconds;
+
+    ++total.ctEntries;
+    total.iSizeIn += entry.iSizeIn;
+    total.iSizeOut += entry.iSizeOut;
+    total.dSeconds += entry.dSeconds;
+
+    aSlowest.push_back(&entry);
+  }
+
+  std::sort(aSlowest.begin(), aSlowest.end(), CompareEntryTime);
+  if (aSlowest.size() > _ctSlowestEntries) aSlowest.resize(_ctSlowestEntries);
+
+  std::map<CString, ExtStats_t>::const_iterator itExt;
+
+  if (_bStats) {
+    std::cout << std::fixed << std::setprecision(3) << "\nTimings:\n";
+
+    for (size_t i = 0; i < _aPhases.size(); ++i) {
+      std::cout << "  " << _aPhases[i].strPhase << ": " << _aPhases[i].dSeconds << " s\n";
+    }
+
+    std::cout << "  Existence checks: " << _ctChecks << " in " << _dCheckSeconds << " s\n";
+
+    if (total.ctEntries != 0) {
+      std::cout << "\nPacked entries: " << total.ctEntries << ", " << total.iSizeIn << " -> " << total.iSizeOut
+        << " bytes (ratio " << Ratio(total.iSizeIn, total.iSizeOut) << ", "
+        << Throughput(total.iSizeIn, total.dSeconds) << " MB/s per thread)\n";
+
+      for (itExt = mapExts.begin(); itExt != mapExts.end(); ++itExt) {
+        const ExtStats_t &ext = itExt->second;
+
+        std::cout << "  " << (itExt->first == "" ? "(none)" : itExt->first) << ": " << ext.ctEntries << " files, "
+          << ext.iSizeIn << " -> " << ext.iSizeOut << " bytes (ratio " << Ratio(ext.iSizeIn, ext.iSizeOut) << ", "
+          << Throughput(ext.iSizeIn, ext.dSeconds) << " MB/s)\n";
+      }
+
+      std::cout << "\nSlowest entries:\n";
+
+      for (size_t i = 0; i < aSlowest.size(); ++i) {
+        const EntryStats_t &entry = *aSlowest[i];
+        std::cout << "  " << entry.strFile << ": " << entry.dSeconds << " s (" << entry.iSizeIn << " bytes)\n";
+      }
+    }
+
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+  }
+
+  if (_strStatsJSON == "") return;
+
+  std::ofstream strm(_strStatsJSON.c_str());
+
+  if (!strm) {
+    std::cout << "Cannot write stats into \"" << _strStatsJSON << "\"!\n";
+    return;
+  }
+
+  strm << std::setprecision(6) << "{\n  \"phases\": [";
+
+  for (size_t i = 0; i < _aPhases.size(); ++i) {
+    strm << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+    WriteJSONString(strm, _aPhases[i].strPhase);
+    strm << ", \"seconds\": " << _aPhases[i].dSeconds << " }";
+  }
+
+  strm << "\n  ],\n  \"checks\": { \"count\": " << _ctChecks << ", \"seconds\": " << _dCheckSeconds << " },\n"
+       << "  \"total\": { \"files\": " << total.ctEntries << ", \"bytes_in\": " << total.iSizeIn
+       << ", \"bytes_out\": " << total.iSizeOut << ", \"ratio\": " << Ratio(total.iSizeIn, total.iSizeOut)
+       << ", \"seconds\": " << total.dSeconds << ", \"mb_per_s\": " << Throughput(total.iSizeIn, total.dSeconds) << " },\n"
+       << "  \"extensions\": {";
+
+  bool bFirst = true;
+
+  for (itExt = mapExts.begin(); itExt != mapExts.end(); ++itExt) {
+    const ExtStats_t &ext = itExt->second;
+
+    strm << (bFirst ? "\n" : ",\n") << "    ";
+    WriteJSONString(strm, itExt->first);
+    strm << ": { \"files\": " << ext.ctEntries << ", \"bytes_in\": " << ext.iSizeIn << ", \"bytes_out\": " << ext.iSizeOut
+         << ", \"ratio\": " << Ratio(ext.iSizeIn, ext.iSizeOut) << ", \"seconds\": " << ext.dSeconds
+         << ", \"mb_per_s\": " << Throughput(ext.iSizeIn, ext.dSeconds) << " }";
+
+    bFirst = false;
+  }
+
+  strm << "\n  },\n  \"slowest\": [";
+
+  for (size_t i = 0; i < aSlowest.size(); ++i) {
+    const EntryStats_t &entry = *aSlowest[i];
+
+    strm << (i == 0 ? "\n" : ",\n") << "    { \"file\": ";
+    WriteJSONString(strm, entry.strFile);
+    strm << ", \"seconds\": " << entry.dSeconds << ", \"bytes_in\": " << entry.iSizeIn << ", \"bytes_out\": " << entry.iSizeOut << " }";
+  }
+
+  strm << "\n  ]\n}\n";
+};
+
+// Forget collected timings before measuring everything again
+void ResetStats(void) {
+  _aPhases.clear();
+  _aEntries.clear();
+
+  _ctChecks = 0;
+  _dCheckSeconds = 0.0;
+};
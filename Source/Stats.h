@@ -0,0 +1,77 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_STATS_H
+#define _DREAMYGRO_INCL_STATS_H
+
+#include "Main.h"
+
+#include <chrono>
+
+extern bool _bStats; // Display timings at the end
+extern CString _strStatsJSON; // File for writing timings in JSON format
+
+inline bool CollectStats(void) {
+  return _bStats || _strStatsJSON != "";
+};
+
+// High resolution timer
+class CStopwatch {
+  private:
+    std::chrono::steady_clock::time_point _tmStart;
+
+  public:
+    CStopwatch() : _tmStart(std::chrono::steady_clock::now()) {};
+
+    // Seconds since the start
+    inline double Seconds(void) const {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - _tmStart).count();
+    };
+};
+
+// Timer that records time of some phase when it goes out of scope (only used on the main thread)
+class CPhaseTimer {
+  private:
+    CString _strPhase;
+    CStopwatch _sw;
+    bool _bActive;
+
+  public:
+    CPhaseTimer(const CString &strPhase);
+    ~CPhaseTimer();
+};
+
+// Record time of some phase
+void AddPhaseTime(const CString &strPhase, double dSeconds);
+
+// Record time of one existence check
+void AddCheckTime(double dSeconds);
+
+// Record one packed entry
+void AddEntryStats(const CString &strFile, u64 iSizeIn, u64 iSizeOut, double dSeconds);
+
+// Display collected timings and write them into a JSON file, if needed
+void ReportStats(void);
+
+// Forget collected timings before measuring everything again
+void ResetStats(void);
+
+#endif
@@ -0,0 +1,123 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "StringArena.h"
+
+#include <algorithm>
+#include <string.h>
+
+CStringArena _arenaNames;
+
+// Characters in one arena block
+static const size_t _ctArenaBlock = 64 * 1024;
+
+CStringArena::~CStringArena() {
+  Clear();
+};
+
+// Release all strings
+void CStringArena::Clear(void) {
+  for (size_t i = 0; i < _aBlocks.size(); ++i) {
+    delete[] _aBlocks[i];
+  }
+
+  _aBlocks.clear();
+  _iBlockUsed = 0;
+  _ctBlockSize = 0;
+
+  _aNames.clear();
+  _index.Clear();
+};
+
+// Copy characters into the arena with a null terminator at the end
+c8 *CStringArena::Allocate(size_t ctChars) {
+  const size_t ctNeeded = ctChars + 1;
+
+  // Start a new block if the string doesn't fit
+  if (_aBlocks.empty() || _ctBlockSize - _iBlockUsed < ctNeeded) {
+    _ctBlockSize = std::max(_ctArenaBlock, ctNeeded);
+    _aBlocks.push_back(new c8[_ctBlockSize]);
+    _iBlockUsed = 0;
+  }
+
+  c8 *pStr = _aBlocks.back() + _iBlockUsed;
+  _iBlockUsed += ctNeeded;
+
+  pStr[ctChars] = '\0';
+  return pStr;
+};
+
+// Get stored copy of a string or store a new one
+CName CStringArena::Intern(const c8 *str, size_t ctChars) {
+  return Intern(str, ctChars, HashFilename(str, ctChars));
+};
+
+// Same as Intern() with an already computed HashFilename()
+CName CStringArena::Intern(const c8 *str, size_t ctChars, u64 iHash) {
+  const std::vector<CName> &aNames = _aNames;
+
+  const size_t iName = _index.Find(iHash, [&](size_t i) {
+    const CName &name = aNames[i];
+    return name.length() == ctChars && memcmp(name.c_str(), str, ctChars) == 0;
+  });
+
+  if (iName != NULL_POS) return _aNames[iName];
+
+  c8 *pStr = Allocate(ctChars);
+  memcpy(pStr, str, ctChars);
+
+  _aNames.push_back(CName(pStr, ctChars));
+  _index.Insert(iHash, _aNames.size() - 1);
+
+  return _aNames.back();
+};
+
+// Store a string in lowercase and return its stored copy
+CName CStringArena::InternFolded(const c8 *str, size_t ctChars, u64 iFoldedHash) {
+  const std::vector<CName> &aNames = _aNames;
+
+  // Lowercase strings have the same hash as the folded ones
+  const size_t iName = _index.Find(iFoldedHash, [&](size_t i) {
+    const CName &name = aNames[i];
+    if (name.length() != ctChars) return false;
+
+    const c8 *strStored = name.c_str();
+
+    for (size_t iChar = 0; iChar < ctChars; ++iChar) {
+      if (strStored[iChar] != FoldChar(str[iChar])) return false;
+    }
+
+    return true;
+  });
+
+  if (iName != NULL_POS) return _aNames[iName];
+
+  c8 *pStr = Allocate(ctChars);
+
+  for (size_t i = 0; i < ctChars; ++i) {
+    pStr[i] = FoldChar(str[i]);
+  }
+
+  _aNames.push_back(CName(pStr, ctChars));
+  _index.Insert(iFoldedHash, _aNames.size() - 1);
+
+  return _aNames.back();
+};
@@ -0,0 +1,116 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_STRINGARENA_H
+#define _DREAMYGRO_INCL_STRINGARENA_H
+
+#include "Hashing.h"
+
+#include <iostream>
+
+// Handle of a null-terminated string that's stored in an arena and never changes
+class CName {
+  private:
+    const c8 *_str;
+    size_t _ctChars;
+
+  public:
+    CName() : _str(""), _ctChars(0) {};
+    CName(const c8 *str, size_t ctChars) : _str(str), _ctChars(ctChars) {};
+
+    inline const c8 *c_str(void) const {
+      return _str;
+    };
+
+    inline size_t length(void) const {
+      return _ctChars;
+    };
+
+    inline bool empty(void) const {
+      return _ctChars == 0;
+    };
+
+    // Make a separate copy of the string
+    inline CString ToString(void) const {
+      return CString(_str, _ctChars);
+    };
+
+    inline bool operator==(const CName &other) const {
+      return _ctChars == other._ctChars && memcmp(_str, other._str, _ctChars) == 0;
+    };
+
+    inline bool operator!=(const CName &other) const {
+      return !(*this == other);
+    };
+};
+
+inline std::ostream &operator<<(std::ostream &strm, const CName &name) {
+  return strm.write(name.c_str(), name.length());
+};
+
+// Bump allocator of strings that stores each unique string only once until it's cleared
+// Not thread-safe; strings are only added from the main thread
+class CStringArena {
+  private:
+    std::vector<c8 *> _aBlocks;
+    size_t _iBlockUsed; // Characters used in the last block
+    size_t _ctBlockSize; // Characters in the last block
+
+    std::vector<CName> _aNames; // Unique strings
+    CHashIndex _index;
+
+  public:
+    CStringArena() : _iBlockUsed(0), _ctBlockSize(0) {};
+    ~CStringArena();
+
+    // Release all strings
+    void Clear(void);
+
+    // Amount of unique strings
+    inline size_t Count(void) const {
+      return _aNames.size();
+    };
+
+    // Get stored copy of a string or store a new one
+    CName Intern(const c8 *str, size_t ctChars);
+
+    // Same as Intern() with an already computed HashFilename()
+    CName Intern(const c8 *str, size_t ctChars, u64 iHash);
+
+    inline CName Intern(const CString &str) {
+      return Intern(str.c_str(), str.length());
+    };
+
+    // Store a string in lowercase and return its stored copy
+    CName InternFolded(const c8 *str, size_t ctChars, u64 iFoldedHash);
+
+  private:
+    // Copy characters into the arena with a null terminator at the end
+    c8 *Allocate(size_t ctChars);
+
+    // Disallow copying
+    CStringArena(const CStringArena &);
+    CStringArena &operator=(const CStringArena &);
+};
+
+extern CStringArena _arenaNames; // Filenames of all dependencies in this run
+
+#endif
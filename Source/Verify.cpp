@@ -0,0 +1,188 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Verify.h"
+#include "GroArchive.h"
+#include "FileSystem.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Comparison of one listed file with its entry
+struct VerifyJob_t {
+  const ListedFile_t *pListed;
+  const GroEntry_t *pEntry; // Entry in the archive
+  CString strSource; // Full path to the file on disk
+  s32 iCheck; // Result of CheckFile()
+  bool bStale; // Entry doesn't match the file
+
+  VerifyJob_t() : pListed(nullptr), pEntry(nullptr), iCheck(0), bStale(false) {};
+};
+
+// Check if the entry still has the same contents as its source
+static void CompareEntry(VerifyJob_t &job) {
+  const GroEntry_t &entry = *job.pEntry;
+
+  // Source file is gone
+  if (job.iCheck == 0) {
+    job.bStale = true;
+    return;
+  }
+
+  // Compare with an entry from the source archive
+  if (job.iCheck == 3) {
+    const GroEntry_t *pSource = _groSources.Find(job.pListed->strFile.ToString());
+    job.bStale = (pSource == nullptr || pSource->iSize != entry.iSize || pSource->iCRC != entry.iCRC);
+    return;
+  }
+
+  // Different sizes don't need hashing
+  FileInfo_t info;
+
+  if (!GetFileInfo(job.strSource, info) || info.iSize != entry.iSize) {
+    job.bStale = true;
+    return;
+  }
+
+  CMappedFile file;
+
+  if (!file.Open(job.strSource) || file.Size() != entry.iSize) {
+    job.bStale = true;
+    return;
+  }
+
+  job.bStale = (ComputeCRC(0, file.Data(), file.Size()) != entry.iCRC);
+};
+
+// Compare entries on multiple threads at the same time
+static void CompareInParallel(std::vector<VerifyJob_t *> &aCompare) {
+  const size_t ctJobs = aCompare.size();
+  const size_t ctThreads = std::min(GetThreadCount(), ctJobs);
+
+  if (ctThreads <= 1) {
+    for (size_t iJob = 0; iJob < ctJobs; ++iJob) {
+      CompareEntry(*aCompare[iJob]);
+    }
+    return;
+  }
+
+  std::atomic<size_t> iNextJob(0);
+  std::vector<std::thread> aThreads;
+
+  for (size_t iThread = 0; iThread < ctThreads; ++iThread) {
+    aThreads.push_back(std::thread([&]() {
+      for (;;) {
+        const size_t iJob = iNextJob++;
+        if (iJob >= ctJobs) break;
+
+        CompareEntry(*aCompare[iJob]);
+      }
+    }));
+  }
+
+  for (size_t iThread = 0; iThread < ctThreads; ++iThread) {
+    aThreads[iThread].join();
+  }
+};
+
+// Display a list of files under some title and return the amount of them
+static size_t DisplayVerifiedFiles(const Strings_t &aFiles, const c8 *strTitle) {
+  if (aFiles.empty()) return 0;
+
+  std::cout << '\n' << strTitle << '\n';
+
+  for (size_t i = 0; i < aFiles.size(); ++i) {
+    std::cout << (i + 1) << ". " << aFiles[i] << '\n';
+  }
+
+  return aFiles.size();
+};
+
+// Compare entries in the output GRO with listed files without decompressing anything
+bool VerifyArchive(const CListedFiles &aFiles) {
+  std::cout << "\nVerifying \"" << _strGRO << "\"...\n";
+
+  CGroReader gro;
+
+  if (!gro.Open(_strGRO)) {
+    std::cout << "Cannot read the archive!\n";
+    return false;
+  }
+
+  const size_t ctFiles = aFiles.Size();
+  std::vector<VerifyJob_t> aJobs(ctFiles);
+  std::vector<VerifyJob_t *> aCompare;
+  std::vector<bool> abListed(gro.Count(), false);
+
+  // Match listed files with entries via the central directory
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    VerifyJob_t &job = aJobs[iFile];
+    job.pListed = &aFiles[iFile];
+
+    const CString strFile = job.pListed->strFile.ToString();
+    job.iCheck = CheckFile(strFile, &job.strSource);
+
+    const size_t iEntry = gro.Find(strFile);
+    if (iEntry == NULL_POS) continue;
+
+    abListed[iEntry] = true;
+    job.pEntry = &gro[iEntry];
+    aCompare.push_back(&job);
+  }
+
+  CompareInParallel(aCompare);
+
+  Strings_t aMissing, aStale, aExtra, aNotOnDisk;
+
+  for (size_t iFile = 0; iFile < ctFiles; ++iFile) {
+    const VerifyJob_t &job = aJobs[iFile];
+    const CString strFile = job.pListed->strFile.ToString();
+
+    if (job.iCheck == 0) aNotOnDisk.push_back(strFile);
+
+    if (job.pEntry == nullptr) {
+      // Files that aren't on disk cannot be packed anyway
+      if (job.iCheck != 0) aMissing.push_back(strFile);
+
+    } else if (job.bStale) {
+      aStale.push_back(strFile);
+    }
+  }
+
+  for (size_t iEntry = 0; iEntry < gro.Count(); ++iEntry) {
+    if (!abListed[iEntry]) aExtra.push_back(gro[iEntry].strName);
+  }
+
+  const size_t ctMissing = DisplayVerifiedFiles(aMissing, "Missing entries:");
+  const size_t ctStale = DisplayVerifiedFiles(aStale, "Stale entries:");
+  const size_t ctExtra = DisplayVerifiedFiles(aExtra, "Extra entries:");
+  DisplayVerifiedFiles(aNotOnDisk, "Files that aren't on disk:");
+
+  if (ctMissing + ctStale + ctExtra == 0) {
+    std::cout << "\nArchive is up to date! (" << aCompare.size() << " entries)\n";
+    return true;
+  }
+
+  std::cout << "\nArchive is outdated: " << ctMissing << " missing, " << ctStale << " stale, " << ctExtra << " extra entries\n";
+  return false;
+};
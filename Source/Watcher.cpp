@@ -0,0 +1,420 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Watcher.h"
+#include "FileSystem.h"
+
+#include <algorithm>
+#include <string.h>
+#include <utility>
+
+#if _DREAMY_UNIX
+  #include <dirent.h>
+  #include <errno.h>
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+
+  #include <map>
+#else
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#endif
+
+#if _DREAMY_UNIX
+
+// Events of files that are being watched
+static const u32 _iWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+struct CFileWatcher::Platform_t {
+  // Watched directory
+  struct Dir_t {
+    CString strDir; // Full path without a trailing slash
+    bool bTree; // Subdirectories that appear in it are being watched as well
+
+    Dir_t() : bTree(false) {};
+  };
+
+  int iNotify;
+  std::map<int, Dir_t> mapDirs; // Watched directories by their watch descriptors
+
+  Platform_t() : iNotify(-1) {};
+
+  ~Platform_t() {
+    if (iNotify != -1) close(iNotify);
+  };
+
+  // Start watching a directory and return false if it doesn't exist
+  bool AddDir(const CString &strDir, bool bTree) {
+    const int iWatch = inotify_add_watch(iNotify, strDir.c_str(), _iWatchMask);
+    if (iWatch == -1) return false;
+
+    Dir_t &dir = mapDirs[iWatch];
+    dir.strDir = strDir;
+    dir.bTree = (dir.bTree || bTree);
+    return true;
+  };
+
+  // Start watching a directory with all of its subdirectories
+  void AddTree(const CString &strDir) {
+    if (!AddDir(strDir, true)) return;
+
+    DIR *pDir = opendir(strDir.c_str());
+    if (pDir == nullptr) return;
+
+    Strings_t aSubdirs;
+
+    for (dirent *pEntry = readdir(pDir); pEntry != nullptr; pEntry = readdir(pDir)) {
+      if (strcmp(pEntry->d_name, ".") == 0 || strcmp(pEntry->d_name, "..") == 0) continue;
+
+      const CString strSubdir = strDir + "/" + pEntry->d_name;
+      bool bDir = (pEntry->d_type == DT_DIR);
+
+      // Some file systems don't report types of entries
+      if (pEntry->d_type == DT_UNKNOWN) {
+        struct stat st;
+        bDir = (stat(strSubdir.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+      }
+
+      if (bDir) aSubdirs.push_back(strSubdir);
+    }
+
+    closedir(pDir);
+
+    for (size_t i = 0; i < aSubdirs.size(); ++i) {
+      AddTree(aSubdirs[i]);
+    }
+  };
+};
+
+#else
+
+struct CFileWatcher::Platform_t {
+  CString strRoot; // Watched directory with all of its subdirectories
+  HANDLE hDir;
+  OVERLAPPED ov;
+  DWORD aBuffer[16384]; // Changes since the last read
+
+  Platform_t() : hDir(INVALID_HANDLE_VALUE) {
+    memset(&ov, 0, sizeof(ov));
+  };
+
+  ~Platform_t() {
+    Close();
+  };
+
+  // Stop watching the directory
+  void Close(void) {
+    if (hDir != INVALID_HANDLE_VALUE) {
+      CancelIo(hDir);
+      CloseHandle(hDir);
+      hDir = INVALID_HANDLE_VALUE;
+    }
+
+    if (ov.hEvent != NULL) {
+      CloseHandle(ov.hEvent);
+      ov.hEvent = NULL;
+    }
+  };
+
+  // Request the next batch of changes
+  bool StartReading(void) {
+    ResetEvent(ov.hEvent);
+
+    const DWORD iFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+    return ReadDirectoryChangesW(hDir, aBuffer, sizeof(aBuffer), TRUE, iFilter, NULL, &ov, NULL) != FALSE;
+  };
+};
+
+#endif
+
+CFileWatcher::CFileWatcher() : _pPlatform(new Platform_t)
+{
+};
+
+CFileWatcher::~CFileWatcher() {
+  delete _pPlatform;
+};
+
+// Replace the list of watched files under the root directory
+void CFileWatcher::SetFiles(const CString &strRoot, const Strings_t &aFiles, const Strings_t &aPatterns) {
+  std::vector<std::pair<CString, CString> > aSorted;
+
+  for (size_t i = 0; i < aFiles.size(); ++i) {
+    if (!aFiles[i].StartsWith(strRoot)) continue;
+
+    aSorted.push_back(std::make_pair(aFiles[i].AsLower(), aFiles[i]));
+  }
+
+  std::sort(aSorted.begin(), aSorted.end());
+
+  _aKeys.clear();
+  _aFiles.clear();
+
+  for (size_t i = 0; i < aSorted.size(); ++i) {
+    // Skip the same file in a different case
+    if (!_aKeys.empty() && _aKeys.back() == aSorted[i].first) continue;
+
+    _aKeys.push_back(aSorted[i].first);
+    _aFiles.push_back(aSorted[i].second);
+  }
+
+  _aPatterns.clear();
+
+  for (size_t i = 0; i < aPatterns.size(); ++i) {
+    if (aPatterns[i].StartsWith(strRoot)) _aPatterns.push_back(aPatterns[i]);
+  }
+};
+
+// Remember change of a file and return false if it isn't being watched
+bool CFileWatcher::AddChange(const CString &strFile, bool bCreatedOrRemoved, Strings_t &aChanged) const {
+  const CString strKey = strFile.AsLower();
+  Strings_t::const_iterator itKey = std::lower_bound(_aKeys.begin(), _aKeys.end(), strKey);
+
+  CString strChanged = strFile;
+
+  if (itKey != _aKeys.end() && *itKey == strKey) {
+    strChanged = _aFiles[itKey - _aKeys.begin()];
+
+  // Check if a new or removed file could've been matched by patterns
+  } else {
+    bool bMatched = false;
+
+    for (size_t i = 0; bCreatedOrRemoved && !bMatched && i < _aPatterns.size(); ++i) {
+      bMatched = MatchFilePattern(_aPatterns[i].c_str(), strFile.c_str());
+    }
+
+    if (!bMatched) return false;
+  }
+
+  if (std::find(aChanged.begin(), aChanged.end(), strChanged) == aChanged.end()) {
+    aChanged.push_back(strChanged);
+  }
+
+  return true;
+};
+
+
+#if _DREAMY_UNIX
+
+// Directory of a pattern that contains all files it can match
+static CString GetPatternDir(const CString &strPattern) {
+  size_t iEnd = strPattern.find_first_of("*?");
+  if (iEnd == NULL_POS) iEnd = strPattern.length();
+
+  const size_t iDir = strPattern.rfind('/', iEnd == 0 ? 0 : iEnd - 1);
+  return (iDir != NULL_POS) ? CString(strPattern.substr(0, iDir)) : CString("");
+};
+
+// Start watching specific files (full paths) under some root directory instead of previous ones
+bool CFileWatcher::Watch(const CString &strRoot, const Strings_t &aFiles, const Strings_t &aPatterns) {
+  Platform_t &p = *_pPlatform;
+
+  if (p.iNotify == -1) {
+    p.iNotify = inotify_init1(IN_CLOEXEC);
+    if (p.iNotify == -1) return false;
+  }
+
+  // Stop watching previous directories
+  for (std::map<int, Platform_t::Dir_t>::const_iterator it = p.mapDirs.begin(); it != p.mapDirs.end(); ++it) {
+    inotify_rm_watch(p.iNotify, it->first);
+  }
+
+  p.mapDirs.clear();
+  SetFiles(strRoot, aFiles, aPatterns);
+
+  // Watch directories instead of files because editors often replace files when saving them
+  Strings_t aDirs;
+
+  for (size_t i = 0; i < _aFiles.size(); ++i) {
+    const CString &strFile = _aFiles[i];
+    aDirs.push_back(strFile.substr(0, strFile.rfind('/')));
+  }
+
+  std::sort(aDirs.begin(), aDirs.end());
+  aDirs.erase(std::unique(aDirs.begin(), aDirs.end()), aDirs.end());
+
+  for (size_t i = 0; i < aDirs.size(); ++i) {
+    // Directories of files that don't exist yet may not exist either
+    p.AddDir(aDirs[i], false);
+  }
+
+  // Files that match patterns may appear in any subdirectory
+  for (size_t i = 0; i < _aPatterns.size(); ++i) {
+    p.AddTree(GetPatternDir(_aPatterns[i]));
+  }
+
+  return !p.mapDirs.empty();
+};
+
+// Wait until any watched file changes and then until there are no more changes for some time
+bool CFileWatcher::Wait(u32 iDelayMs, Strings_t &aChanged, bool &bCreatedOrRemoved) {
+  Platform_t &p = *_pPlatform;
+
+  aChanged.clear();
+  bCreatedOrRemoved = false;
+
+  if (p.iNotify == -1) return false;
+
+  // Events are aligned like their structure
+  u64 aBuffer[1024];
+
+  for (;;) {
+    // Wait indefinitely for the first change
+    pollfd fd;
+    fd.fd = p.iNotify;
+    fd.events = POLLIN;
+    fd.revents = 0;
+
+    const int iReady = poll(&fd, 1, aChanged.empty() ? -1 : (int)iDelayMs);
+
+    if (iReady < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    // No more changes
+    if (iReady == 0) break;
+
+    const ssize_t iRead = read(p.iNotify, aBuffer, sizeof(aBuffer));
+
+    if (iRead < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    const u8 *pEvent = (const u8 *)aBuffer;
+    const u8 *pEnd = pEvent + iRead;
+
+    while (pEvent < pEnd) {
+      const inotify_event *pInfo = (const inotify_event *)pEvent;
+      pEvent += sizeof(inotify_event) + pInfo->len;
+
+      // Too many changes to tell which files have actually changed
+      if (pInfo->mask & IN_Q_OVERFLOW) {
+        aChanged = _aFiles;
+        bCreatedOrRemoved = true;
+        continue;
+      }
+
+      std::map<int, Platform_t::Dir_t>::const_iterator itDir = p.mapDirs.find(pInfo->wd);
+      if (itDir == p.mapDirs.end() || pInfo->len == 0) continue;
+
+      const CString strFile = itDir->second.strDir + "/" + pInfo->name;
+      const bool bCreatedOrRemovedFile = !(pInfo->mask & IN_CLOSE_WRITE);
+
+      // Keep watching new subdirectories for files that match patterns
+      if ((pInfo->mask & IN_ISDIR) && (pInfo->mask & (IN_CREATE | IN_MOVED_TO)) && itDir->second.bTree) {
+        p.AddTree(strFile);
+        continue;
+      }
+
+      if (AddChange(strFile, bCreatedOrRemovedFile, aChanged) && bCreatedOrRemovedFile) {
+        bCreatedOrRemoved = true;
+      }
+    }
+  }
+
+  return true;
+};
+
+#else
+
+// Start watching specific files (full paths) under some root directory instead of previous ones
+bool CFileWatcher::Watch(const CString &strRoot, const Strings_t &aFiles, const Strings_t &aPatterns) {
+  Platform_t &p = *_pPlatform;
+  SetFiles(strRoot, aFiles, aPatterns);
+
+  // Keep watching the same directory
+  if (p.hDir != INVALID_HANDLE_VALUE && p.strRoot == strRoot) return true;
+
+  p.Close();
+
+  p.hDir = CreateFileA(strRoot.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+    NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+  if (p.hDir == INVALID_HANDLE_VALUE) return false;
+
+  p.ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+  p.strRoot = strRoot;
+
+  return p.ov.hEvent != NULL && p.StartReading();
+};
+
+// Wait until any watched file changes and then until there are no more changes for some time
+bool CFileWatcher::Wait(u32 iDelayMs, Strings_t &aChanged, bool &bCreatedOrRemoved) {
+  Platform_t &p = *_pPlatform;
+
+  aChanged.clear();
+  bCreatedOrRemoved = false;
+
+  if (p.hDir == INVALID_HANDLE_VALUE) return false;
+
+  for (;;) {
+    // Wait indefinitely for the first change
+    const DWORD iWait = WaitForSingleObject(p.ov.hEvent, aChanged.empty() ? INFINITE : iDelayMs);
+
+    // No more changes
+    if (iWait == WAIT_TIMEOUT) break;
+    if (iWait != WAIT_OBJECT_0) return false;
+
+    DWORD iRead = 0;
+    if (!GetOverlappedResult(p.hDir, &p.ov, &iRead, FALSE)) return false;
+
+    // Too many changes to tell which files have actually changed
+    if (iRead == 0) {
+      aChanged = _aFiles;
+      bCreatedOrRemoved = true;
+
+    } else {
+      const u8 *pEvent = (const u8 *)p.aBuffer;
+
+      for (;;) {
+        const FILE_NOTIFY_INFORMATION *pInfo = (const FILE_NOTIFY_INFORMATION *)pEvent;
+
+        c8 strName[MAX_PATH * 4];
+        const int ctChars = WideCharToMultiByte(CP_ACP, 0, pInfo->FileName, pInfo->FileNameLength / sizeof(WCHAR),
+          strName, sizeof(strName), NULL, NULL);
+
+        if (ctChars > 0) {
+          CString strFile = p.strRoot + CString(strName, ctChars);
+          strFile.Normalize();
+
+          const bool bCreatedOrRemovedFile = (pInfo->Action != FILE_ACTION_MODIFIED);
+
+          if (AddChange(strFile, bCreatedOrRemovedFile, aChanged) && bCreatedOrRemovedFile) {
+            bCreatedOrRemoved = true;
+          }
+        }
+
+        if (pInfo->NextEntryOffset == 0) break;
+        pEvent += pInfo->NextEntryOffset;
+      }
+    }
+
+    if (!p.StartReading()) return false;
+  }
+
+  return true;
+};
+
+#endif
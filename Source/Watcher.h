@@ -0,0 +1,62 @@
+/* Copyright (c) 2022-2024 Dreamy Cecil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _DREAMYGRO_INCL_WATCHER_H
+#define _DREAMYGRO_INCL_WATCHER_H
+
+#include "Main.h"
+
+// Notifications about changes of specific files on disk
+class CFileWatcher {
+  private:
+    struct Platform_t; // Platform-specific notification handles
+
+    Strings_t _aKeys; // Watched files as full paths in lowercase (sorted)
+    Strings_t _aFiles; // Watched files in the same order as their keys
+    Strings_t _aPatterns; // Full paths with wildcards of files that may be created or removed
+    Platform_t *_pPlatform;
+
+    // Cannot be copied
+    CFileWatcher(const CFileWatcher &other);
+    CFileWatcher &operator=(const CFileWatcher &other);
+
+  public:
+    CFileWatcher();
+    ~CFileWatcher();
+
+    // Start watching specific files (full paths) under some root directory instead of previous ones
+    // Creation and removal of any files that match the patterns (see MatchFilePattern()) count as changes as well
+    // Files outside the root directory aren't being watched
+    bool Watch(const CString &strRoot, const Strings_t &aFiles, const Strings_t &aPatterns);
+
+    // Wait until any watched file changes and then until there are no more changes for some time
+    // Collects full paths of changed files and whether any of them have been created or removed
+    bool Wait(u32 iDelayMs, Strings_t &aChanged, bool &bCreatedOrRemoved);
+
+  private:
+    // Replace the list of watched files under the root directory
+    void SetFiles(const CString &strRoot, const Strings_t &aFiles, const Strings_t &aPatterns);
+
+    // Remember change of a file and return false if it isn't being watched
+    bool AddChange(const CString &strFile, bool bCreatedOrRemoved, Strings_t &aChanged) const;
+};
+
+#endif